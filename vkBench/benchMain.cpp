@@ -0,0 +1,433 @@
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include "vkDevice.h"
+#include "vkTrace.h"
+#include "vkObjectPool.h"
+#include "vkParticles.h"
+#include "vkPostProcess.h"
+#include "vkSamplerCache.h"
+#include "benchReport.h"
+
+#ifdef _MSC_VER
+#pragma comment(lib, "vulkan-1")
+#endif
+
+// vkBench: headless micro benchmarks for the vkTest wrappers
+// Usage: vkBench [--device=<name substring>] [--shaders=<dir>] [--quick] [--out=<file.json>]
+//                [--baseline=<file.json>] [--threshold=<relative, default 0.1>]
+//        vkBench --replay=<trace.bin> [--loops=N] [--frames-out=<file.csv>] [--device=...] [--out=...] [--baseline=...]
+// --replay re-executes a trace captured by vkTest --capture instead of the micro benchmarks(frame time metrics).
+// Runs without any window system, so it works on software ICDs(e.g. VK_ICD_FILENAMES pointing lavapipe or SwiftShader).
+// Exit code: 0 = ok, 1 = regressed against baseline, 2 = error
+struct BenchOptions
+{
+	std::string deviceFilter, shaderDir, outPath, baselinePath;
+	double threshold;
+	uint32_t scale;		// iteration divisor(--quick = 10)
+	std::string replayPath, framesOutPath;
+	uint32_t loops;		// replay passes over the whole trace
+};
+auto parseBenchOptions(const std::string& cmdLine)
+{
+	BenchOptions options{ std::string(), std::string(), std::string(), std::string(), 0.1, 1, std::string(), std::string(), 1 };
+	const auto value = [&](const char* key)
+	{
+		auto pos = cmdLine.find(key);
+		if (pos == std::string::npos) return std::string();
+		pos += strlen(key);
+		return cmdLine.substr(pos, cmdLine.find(' ', pos) - pos);
+	};
+
+	options.deviceFilter = value("--device=");
+	options.shaderDir = value("--shaders=");
+	options.outPath = value("--out=");
+	options.baselinePath = value("--baseline=");
+	if (!value("--threshold=").empty()) options.threshold = strtod(value("--threshold=").c_str(), nullptr);
+	if (cmdLine.find("--quick") != std::string::npos) options.scale = 10;
+	options.replayPath = value("--replay=");
+	options.framesOutPath = value("--frames-out=");
+	if (!value("--loops=").empty()) options.loops = std::max(1ul, strtoul(value("--loops=").c_str(), nullptr, 10));
+	return options;
+}
+
+// Timing: median of several runs, each averaged over iterations
+using BenchClock = std::chrono::steady_clock;
+template<typename FuncT>
+double measureSeconds(uint32_t iterations, FuncT f)
+{
+	const uint32_t runs = 5;
+	double samples[runs];
+	f();	// warmup
+	for (uint32_t r = 0; r < runs; r++)
+	{
+		const auto start = BenchClock::now();
+		for (uint32_t i = 0; i < iterations; i++) f();
+		samples[r] = std::chrono::duration<double>(BenchClock::now() - start).count() / iterations;
+	}
+	std::sort(samples, samples + runs);
+	return samples[runs / 2];
+}
+// keeps results alive against the optimizer
+static volatile uint64_t benchSink;
+
+VkPhysicalDevice selectPhysicalDevice(const Vulkan::Instance& instance, const std::string& filter, std::string& name)
+{
+	uint32_t count;
+	auto res = vkEnumeratePhysicalDevices(instance.get(), &count, nullptr);
+	Vulkan::checkError(res);
+	std::vector<VkPhysicalDevice> adapters(count);
+	res = vkEnumeratePhysicalDevices(instance.get(), &count, adapters.data());
+	Vulkan::checkError(res);
+	for (auto a : adapters)
+	{
+		VkPhysicalDeviceProperties props;
+		vkGetPhysicalDeviceProperties(a, &props);
+		if (filter.empty() || strstr(props.deviceName, filter.c_str()) != nullptr)
+		{
+			name = props.deviceName;
+			return a;
+		}
+	}
+	throw std::runtime_error("No physical device matches --device=" + filter);
+}
+
+struct VertexData
+{
+	float pos[2];
+	float color[4];
+};
+static VertexData smallVertices[1024], mediumVertices[64 * 1024], largeVertices[1024 * 1024];
+
+void runBenchmarks(const BenchOptions& options, std::vector<Bench::Result>& results, std::string& deviceName)
+{
+	const auto iterations = [&](uint32_t n) { return std::max(1u, n / options.scale); };
+	const auto shaderPath = [&](const wchar_t* file)
+	{
+		std::wstring path(options.shaderDir.begin(), options.shaderDir.end());
+		if (!path.empty() && path.back() != L'/' && path.back() != L'\\') path += L'/';
+		return path + file;
+	};
+
+	auto instance = Vulkan::createInstance(Vulkan::RuntimeProfile::Release, std::vector<const char*>());
+	auto pDevice = selectPhysicalDevice(instance, options.deviceFilter, deviceName);
+	auto device = Vulkan::Device::create(pDevice, Vulkan::RuntimeProfile::Release, nullptr, false);
+	auto cmdPool = device.createCommandPool();
+	auto fence = device.createFence();
+	auto cmdBuffers = device.createCommandBuffers(cmdPool, 1);
+
+	// UniqueObject lifecycle(no-op destroyer isolates the wrapper cost from the driver)
+	{
+		auto rawFence = device.createFence();
+		const auto handle = rawFence.get();
+		const auto noDestroy = [](VkDevice, VkFence, const VkAllocationCallbacks*) {};
+		results.push_back(Bench::Result{ "uniqueObject.constructDestroy", "ns",
+			1.0e9 * measureSeconds(iterations(1000000), [&]()
+			{
+				Vulkan::Fence f(device.handle(), handle, noDestroy);
+				benchSink += f.get() != VK_NULL_HANDLE;
+			}), false });
+		results.push_back(Bench::Result{ "uniqueObject.move", "ns",
+			1.0e9 * measureSeconds(iterations(1000000), [&]()
+			{
+				Vulkan::Fence a(device.handle(), handle, noDestroy);
+				Vulkan::Fence b(std::move(a));
+				a = std::move(b);
+				benchSink += a.get() != VK_NULL_HANDLE;
+			}), false });
+		results.push_back(Bench::Result{ "uniqueObject.fenceCreateDestroy", "ns",
+			1.0e9 * measureSeconds(iterations(10000), [&]() { auto f = device.createFence(); }), false });
+	}
+
+	// Pooled sync objects and command buffers(steady state: no create/destroy calls)
+	{
+		Vulkan::FencePool fencePool(device, 1);
+		Vulkan::CommandBufferPool commandBufferPool(device);
+		results.push_back(Bench::Result{ "pool.fenceAcquireRelease", "ns",
+			1.0e9 * measureSeconds(iterations(1000000), [&]() { auto f = fencePool.acquire(); }), false });
+		results.push_back(Bench::Result{ "pool.commandBufferAcquireRelease", "ns",
+			1.0e9 * measureSeconds(iterations(1000000), [&]() { auto b = commandBufferPool.acquire(); }), false });
+	}
+
+	// Image views and framebuffers over a set of render targets
+	{
+		const uint32_t targetCount = 8;
+		auto targets = device.createRenderTargetImages(targetCount, VkExtent2D{ 640, 480 }, VK_FORMAT_B8G8R8A8_UNORM);
+		auto images = Vulkan::imageHandles(targets);
+		auto renderPass = device.createCommonRenderPass(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+		auto views = device.createImageViews(images);
+		results.push_back(Bench::Result{ "createImageViews", "views/s",
+			targetCount / measureSeconds(iterations(2000), [&]() { auto v = device.createImageViews(images); }), true });
+		results.push_back(Bench::Result{ "createFramebuffers", "framebuffers/s",
+			targetCount / measureSeconds(iterations(2000), [&]() { auto fb = device.createFramebuffers(renderPass, views); }), true });
+	}
+
+	// Vertex upload bandwidth(allocate + map + copy + bind)
+	{
+		const auto bandwidth = [&](const char* name, size_t bytes, uint32_t n, auto upload)
+		{
+			results.push_back(Bench::Result{ name, "MB/s", bytes / (1024.0 * 1024.0) / measureSeconds(iterations(n), upload), true });
+		};
+		bandwidth("createVertexBuffer.24KB", sizeof(smallVertices), 2000, [&]() { auto b = device.createVertexBuffer(smallVertices); });
+		bandwidth("createVertexBuffer.1536KB", sizeof(mediumVertices), 200, [&]() { auto b = device.createVertexBuffer(mediumVertices); });
+		bandwidth("createVertexBuffer.24MB", sizeof(largeVertices), 20, [&]() { auto b = device.createVertexBuffer(largeVertices); });
+	}
+
+	// Pipeline creation and draw throughput share the same render pass and pipeline description
+	static VkVertexInputBindingDescription bindDesc
+	{
+		0, sizeof(VertexData), VK_VERTEX_INPUT_RATE_VERTEX
+	};
+	static VkVertexInputAttributeDescription attrDescs[] =
+	{
+		{ 0, 0, VK_FORMAT_R32G32_SFLOAT, 0 },
+		{ 1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(float) * 2 }
+	};
+	auto vs = device.createShaderModule(shaderPath(L"VertexShader.vert.spv"));
+	auto fs = device.createShaderModule(shaderPath(L"FragmentShader.frag.spv"));
+	auto pLayout = device.createPipelineLayout();
+	auto renderPass = device.createCommonRenderPass(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+	const auto pipelineDesc = Vulkan::Device::describeGraphicsPipelineVF(vs, fs, bindDesc, attrDescs, pLayout, renderPass);
+	{
+		// cold: empty VkPipelineCache each time, warm: the cache already holds this pipeline
+		results.push_back(Bench::Result{ "pipeline.cold", "us",
+			1.0e6 * measureSeconds(iterations(50), [&]()
+			{
+				auto cache = device.createPipelineCache();
+				auto p = device.createGraphicsPipeline(pipelineDesc, cache);
+			}), false });
+		auto warmCache = device.createPipelineCache();
+		results.push_back(Bench::Result{ "pipeline.warm", "us",
+			1.0e6 * measureSeconds(iterations(50), [&]() { auto p = device.createGraphicsPipeline(pipelineDesc, warmCache); }), false });
+		const auto compileWarm = [&](const Vulkan::GraphicsPipelineDesc& desc) { return device.createGraphicsPipeline(desc, warmCache); };
+		Vulkan::PipelineStateCache psoCache(compileWarm);
+		results.push_back(Bench::Result{ "pipeline.stateCacheHit", "us",
+			1.0e6 * measureSeconds(iterations(100000), [&]() { benchSink += psoCache.get(pipelineDesc).use_count(); }), false });
+		// Asynchronous miss: request() starts a background compile and returns the(empty) fallback,
+		// then is polled as pending hits until the compiled pipeline is resolved
+		results.push_back(Bench::Result{ "pipeline.stateCacheRequestMiss", "us",
+			1.0e6 * measureSeconds(iterations(50), [&]()
+			{
+				Vulkan::PipelineStateCache asyncCache(compileWarm);
+				while (!asyncCache.request(pipelineDesc)) std::this_thread::yield();
+			}), false });
+	}
+
+	// Draws per second against instance count(one submission of drawCount draws)
+	{
+		auto targets = device.createRenderTargetImages(1, VkExtent2D{ 640, 480 }, VK_FORMAT_B8G8R8A8_UNORM);
+		auto images = Vulkan::imageHandles(targets);
+		auto views = device.createImageViews(images);
+		auto framebuffers = device.createFramebuffers(renderPass, views);
+		auto pCache = device.createPipelineCache();
+		auto pipeline = device.createGraphicsPipeline(pipelineDesc, pCache);
+		static VertexData triangle[] = {
+			{ { 0.0f, -0.75f }, { 1.0f, 1.0f, 1.0f, 1.0f } },
+			{ { -0.5f, 0.75f }, { 1.0f, 0.5f, 0.0f, 1.0f } },
+			{ { 0.5f, 0.75f }, { 0.0f, 0.5f, 1.0f, 1.0f } }
+		};
+		auto vertices = device.createVertexBuffer(triangle);
+
+		Vulkan::beginCommandWithFramebuffer(cmdBuffers[0], Vulkan::Framebuffer());
+		Vulkan::initialImageLayouting(cmdBuffers[0], images, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+		auto res = vkEndCommandBuffer(cmdBuffers[0]);
+		Vulkan::checkError(res);
+		device.submitCommandAndWait(cmdBuffers[0]);
+
+		const uint32_t drawCount = 1000;
+		for (uint32_t instanceCount : { 1u, 16u, 256u })
+		{
+			static VkViewport vp = { 0.0f, 0.0f, 640.0f, 480.0f, 0.0f, 1.0f };
+			static VkRect2D sc = { { 0, 0 }, { 640, 480 } };
+			static VkDeviceSize offsets[] = { 0 };
+
+			const auto seconds = measureSeconds(iterations(20), [&]()
+			{
+				Vulkan::beginCommandWithFramebuffer(cmdBuffers[0], framebuffers.first[0]);
+				Vulkan::barrierResource(cmdBuffers[0], images.first[0],
+					VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+					VK_ACCESS_MEMORY_READ_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+					VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+				Vulkan::beginRenderPass(cmdBuffers[0], framebuffers.first[0], renderPass);
+				vkCmdBindPipeline(cmdBuffers[0], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.get());
+				vkCmdSetViewport(cmdBuffers[0], 0, 1, &vp);
+				vkCmdSetScissor(cmdBuffers[0], 0, 1, &sc);
+				vkCmdBindVertexBuffers(cmdBuffers[0], 0, 1, &vertices.first.get(), offsets);
+				for (uint32_t i = 0; i < drawCount; i++) vkCmdDraw(cmdBuffers[0], 3, instanceCount, 0, 0);
+				vkCmdEndRenderPass(cmdBuffers[0]);
+				vkEndCommandBuffer(cmdBuffers[0]);
+
+				device.submitCommands(cmdBuffers[0], fence);
+				if (device.waitForFence(fence) != VK_SUCCESS) throw std::runtime_error("Command execution timed out.");
+				device.resetFence(fence);
+			});
+			results.push_back(Bench::Result{ "draws.instances" + std::to_string(instanceCount), "draws/s", drawCount / seconds, true });
+		}
+	}
+
+	// Compute particle simulation throughput(one step per submission)
+	{
+		auto pCache = device.createPipelineCache();
+		for (uint32_t count : { 65536u, 1048576u })
+		{
+			Vulkan::ParticleSystem particles(device, pCache, count, true, shaderPath(L"Particles.comp.spv"));
+			const auto seconds = measureSeconds(iterations(50), [&]()
+			{
+				Vulkan::beginCommandWithFramebuffer(cmdBuffers[0], Vulkan::Framebuffer());
+				particles.simulate(cmdBuffers[0], 1.0f / 60.0f);
+				vkEndCommandBuffer(cmdBuffers[0]);
+
+				device.submitCommands(cmdBuffers[0], fence);
+				if (device.waitForFence(fence) != VK_SUCCESS) throw std::runtime_error("Command execution timed out.");
+				device.resetFence(fence);
+			});
+			results.push_back(Bench::Result{ "particles.simulate" + std::to_string(count / 1024) + "K", "Mparticles/s", count / seconds / 1.0e6, true });
+		}
+	}
+
+	// Post-processing chain on the compute queue(full and half resolution, one chain per submission)
+	{
+		auto pCache = device.createPipelineCache();
+		Vulkan::SamplerCache samplers([&](const VkSamplerCreateInfo& info) { return device.createSampler(info); });
+		auto scene = device.createSharedRenderTargetImages(1, VkExtent2D{ 640, 480 }, VK_FORMAT_B8G8R8A8_UNORM);
+		auto sceneImages = Vulkan::imageHandles(scene);
+		auto sceneViews = device.createImageViews(sceneImages);
+		Vulkan::beginCommandWithFramebuffer(cmdBuffers[0], Vulkan::Framebuffer());
+		Vulkan::initialImageLayouting(cmdBuffers[0], sceneImages, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		auto res = vkEndCommandBuffer(cmdBuffers[0]);
+		Vulkan::checkError(res);
+		device.submitCommandAndWait(cmdBuffers[0]);
+
+		Vulkan::FencePool fencePool(device, 1);
+		Vulkan::CommandBufferPool computeCommands(device, device.computeQueueFamily());
+		for (const auto scale : { 1.0, 0.5 })
+		{
+			Vulkan::PostProcessChain chain(device, pCache, samplers.getLinear(VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, 0.0f),
+				{ sceneViews.first[0].get() }, VkExtent2D{ 640, 480 }, scale, shaderPath(L""));
+			const auto seconds = measureSeconds(iterations(50), [&]()
+			{
+				auto commands = computeCommands.acquire();
+				Vulkan::beginCommandWithFramebuffer(commands.get(), Vulkan::Framebuffer());
+				chain.record(commands.get(), 0);
+				vkEndCommandBuffer(commands.get());
+
+				auto postFence = fencePool.acquire();
+				device.submitCommands(device.computeQueue(), commands.get(), {}, 0, {}, postFence);
+				if (device.waitForFence(postFence) != VK_SUCCESS) throw std::runtime_error("Command execution timed out.");
+				computeCommands.retire(std::move(commands), std::move(postFence));
+			});
+			results.push_back(Bench::Result{ std::string(scale < 1.0 ? "post.chainHalfRes" : "post.chainFullRes"), "frames/s", 1.0 / seconds, true });
+		}
+	}
+}
+
+// Trace replay: per-frame CPU recording and GPU execution time of captured frames
+void runReplay(const BenchOptions& options, std::vector<Bench::Result>& results, std::string& deviceName)
+{
+	auto instance = Vulkan::createInstance(Vulkan::RuntimeProfile::Release, std::vector<const char*>());
+	auto pDevice = selectPhysicalDevice(instance, options.deviceFilter, deviceName);
+	auto device = Vulkan::Device::create(pDevice, Vulkan::RuntimeProfile::Release, nullptr, false);
+	Vulkan::TracePlayer player(device, std::wstring(options.replayPath.begin(), options.replayPath.end()));
+	if (player.frameCount() == 0) throw std::runtime_error("Trace contains no frames");
+
+	const auto start = BenchClock::now();
+	const auto timings = player.replay(options.loops);
+	const auto seconds = std::chrono::duration<double>(BenchClock::now() - start).count();
+
+	if (!options.framesOutPath.empty())
+	{
+		auto fp = BinaryLoader::openForWrite(options.framesOutPath, "w");
+		fputs("frame,loop,recordMs,executeMs\n", fp.get());
+		for (size_t i = 0; i < timings.size(); i++)
+		{
+			fprintf(fp.get(), "%u,%u,%.4f,%.4f\n", static_cast<uint32_t>(i % player.frameCount()), static_cast<uint32_t>(i / player.frameCount()),
+				timings[i].recordMilliseconds, timings[i].executeMilliseconds);
+		}
+	}
+
+	std::vector<double> frameTimes;
+	auto recordTotal = 0.0;
+	for (const auto& t : timings)
+	{
+		frameTimes.push_back(t.recordMilliseconds + t.executeMilliseconds);
+		recordTotal += t.recordMilliseconds;
+	}
+	std::sort(frameTimes.begin(), frameTimes.end());
+	const auto percentile = [&](double p) { return frameTimes[std::min(frameTimes.size() - 1, static_cast<size_t>(p * frameTimes.size()))]; };
+	auto frameTotal = 0.0;
+	for (const auto t : frameTimes) frameTotal += t;
+
+	results.push_back(Bench::Result{ "replay.frame.avg", "ms", frameTotal / frameTimes.size(), false });
+	results.push_back(Bench::Result{ "replay.frame.p50", "ms", percentile(0.5), false });
+	results.push_back(Bench::Result{ "replay.frame.p95", "ms", percentile(0.95), false });
+	results.push_back(Bench::Result{ "replay.frame.max", "ms", frameTimes.back(), false });
+	results.push_back(Bench::Result{ "replay.record.avg", "ms", recordTotal / frameTimes.size(), false });
+	results.push_back(Bench::Result{ "replay.fps", "frames/s", frameTimes.size() / seconds, true });
+}
+
+int main(int argc, char** argv)
+{
+	std::string cmdLine;
+	for (int i = 1; i < argc; i++) cmdLine += std::string(argv[i]) + " ";
+	const auto options = parseBenchOptions(cmdLine);
+
+	std::vector<Bench::Result> results;
+	std::string deviceName;
+	try
+	{
+		if (options.replayPath.empty()) runBenchmarks(options, results, deviceName);
+		else runReplay(options, results, deviceName);
+	}
+	catch (const std::exception& e)
+	{
+		fprintf(stderr, "vkBench: %s\n", e.what());
+		return 2;
+	}
+
+	const auto json = Bench::writeJson(deviceName, results);
+	if (options.outPath.empty()) fputs(json.c_str(), stdout);
+	else
+	{
+		try { fputs(json.c_str(), BinaryLoader::openForWrite(options.outPath).get()); }
+		catch (const std::exception& e)
+		{
+			fprintf(stderr, "vkBench: %s\n", e.what());
+			return 2;
+		}
+	}
+
+	if (options.baselinePath.empty()) return 0;
+	std::vector<Bench::Comparison> comparisons;
+	try { comparisons = Bench::compare(Bench::loadJson(options.baselinePath), results, options.threshold); }
+	catch (const std::exception& e)
+	{
+		fprintf(stderr, "vkBench: %s\n", e.what());
+		return 2;
+	}
+	auto regressed = false;
+	for (const auto& c : comparisons)
+	{
+		if (c.missing)
+		{
+			fprintf(stderr, "%-36s %12.4g -> %12s  MISSING\n", c.name.c_str(), c.baseline, "-");
+			regressed = true;
+			continue;
+		}
+		fprintf(stderr, "%-36s %12.4g -> %12.4g  %+7.2f%% (threshold %.0f%%)%s\n", c.name.c_str(), c.baseline, c.current,
+			c.change * 100.0, c.threshold * 100.0, c.regressed ? "  REGRESSED" : "");
+		regressed |= c.regressed;
+	}
+	return regressed ? 1 : 0;
+}
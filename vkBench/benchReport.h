@@ -0,0 +1,203 @@
+#pragma once
+
+#include <map>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "binaryLoader.h"
+
+namespace Bench
+{
+	struct Result
+	{
+		std::string name, unit;
+		double value;
+		bool higherIsBetter;
+	};
+
+	// Minimal JSON value(just enough to read reports written by writeJson)
+	struct JsonValue
+	{
+		enum class Type { Null, Bool, Number, String, Array, Object } type = Type::Null;
+		bool boolean = false;
+		double number = 0.0;
+		std::string string;
+		std::vector<JsonValue> array;
+		std::map<std::string, JsonValue> object;
+
+		const JsonValue* find(const std::string& key) const
+		{
+			auto found = this->object.find(key);
+			return found != this->object.end() ? &found->second : nullptr;
+		}
+	};
+	class JsonParser final
+	{
+		const char* p;
+
+		void skipSpaces() { while (*this->p == ' ' || *this->p == '\t' || *this->p == '\r' || *this->p == '\n') this->p++; }
+		void expect(char c)
+		{
+			this->skipSpaces();
+			if (*this->p != c) throw std::runtime_error(std::string("JSON: expected '") + c + "'");
+			this->p++;
+		}
+		std::string parseString()
+		{
+			this->expect('"');
+			std::string s;
+			while (*this->p != '"')
+			{
+				if (*this->p == 0) throw std::runtime_error("JSON: unterminated string");
+				if (*this->p == '\\' && this->p[1] != 0) this->p++;
+				s += *this->p++;
+			}
+			this->p++;
+			return s;
+		}
+		void literal(const char* word)
+		{
+			const auto length = strlen(word);
+			if (strncmp(this->p, word, length) != 0) throw std::runtime_error(std::string("JSON: expected ") + word);
+			this->p += length;
+		}
+	public:
+		JsonParser(const char* text) : p(text) {}
+
+		JsonValue parse()
+		{
+			JsonValue v;
+			this->skipSpaces();
+			switch (*this->p)
+			{
+			case '{':
+				v.type = JsonValue::Type::Object;
+				this->p++;
+				this->skipSpaces();
+				if (*this->p == '}') { this->p++; break; }
+				for (;;)
+				{
+					auto key = this->parseString();
+					this->expect(':');
+					v.object[key] = this->parse();
+					this->skipSpaces();
+					if (*this->p == ',') { this->p++; continue; }
+					this->expect('}');
+					break;
+				}
+				break;
+			case '[':
+				v.type = JsonValue::Type::Array;
+				this->p++;
+				this->skipSpaces();
+				if (*this->p == ']') { this->p++; break; }
+				for (;;)
+				{
+					v.array.push_back(this->parse());
+					this->skipSpaces();
+					if (*this->p == ',') { this->p++; continue; }
+					this->expect(']');
+					break;
+				}
+				break;
+			case '"':
+				v.type = JsonValue::Type::String;
+				v.string = this->parseString();
+				break;
+			case 't': case 'f':
+				v.type = JsonValue::Type::Bool;
+				v.boolean = *this->p == 't';
+				this->literal(v.boolean ? "true" : "false");
+				break;
+			case 'n':
+				this->literal("null");
+				break;
+			default:
+			{
+				char* end;
+				v.type = JsonValue::Type::Number;
+				v.number = strtod(this->p, &end);
+				if (end == this->p) throw std::runtime_error("JSON: unexpected character");
+				this->p = end;
+				break;
+			}
+			}
+			return v;
+		}
+	};
+
+	std::string escape(const std::string& s)
+	{
+		std::string out;
+		for (auto c : s)
+		{
+			if (c == '"' || c == '\\') out += '\\';
+			out += c;
+		}
+		return out;
+	}
+	// { "device": ..., "results": [ { "name", "unit", "value", "higherIsBetter" }, ... ] }
+	std::string writeJson(const std::string& device, const std::vector<Result>& results)
+	{
+		std::string json = "{\n  \"device\": \"" + escape(device) + "\",\n  \"results\": [\n";
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			char value[64];
+			snprintf(value, sizeof(value), "%.6g", results[i].value);
+			json += "    { \"name\": \"" + escape(results[i].name) + "\", \"unit\": \"" + escape(results[i].unit) + "\", \"value\": " + value
+				+ ", \"higherIsBetter\": " + (results[i].higherIsBetter ? "true" : "false") + " }";
+			json += i + 1 < results.size() ? ",\n" : "\n";
+		}
+		json += "  ]\n}\n";
+		return json;
+	}
+
+	// Baseline comparison
+	// Each baseline result may carry its own "threshold"(relative, e.g. 0.1 = 10%); otherwise defaultThreshold applies.
+	// A baseline result the current run did not produce counts as a regression.
+	struct Comparison
+	{
+		std::string name;
+		double baseline, current;
+		double change;		// relative change, positive = better
+		double threshold;
+		bool missing;		// not measured in the current run
+		bool regressed;
+	};
+	std::vector<Comparison> compare(const JsonValue& baseline, const std::vector<Result>& results, double defaultThreshold)
+	{
+		std::vector<Comparison> comparisons;
+		const auto entries = baseline.find("results");
+		if (entries == nullptr) throw std::runtime_error("Baseline has no results");
+		for (const auto& e : entries->array)
+		{
+			const auto name = e.find("name"), value = e.find("value");
+			if (name == nullptr || value == nullptr) continue;
+			const auto threshold = e.find("threshold") != nullptr ? e.find("threshold")->number : defaultThreshold;
+			const auto base = value->number;
+			auto found = false;
+			for (const auto& r : results)
+			{
+				if (r.name != name->string) continue;
+				auto change = base == 0.0 ? 0.0 : (r.value - base) / std::fabs(base);
+				if (!r.higherIsBetter) change = -change;
+				comparisons.push_back(Comparison{ r.name, base, r.value, change, threshold, false, change < -threshold });
+				found = true;
+			}
+			if (!found) comparisons.push_back(Comparison{ name->string, base, 0.0, 0.0, threshold, true, true });
+		}
+		return comparisons;
+	}
+	auto loadJson(const std::string& path)
+	{
+		const auto data = BinaryLoader::load(std::wstring(path.begin(), path.end()));
+		const std::string text(reinterpret_cast<const char*>(data.first.get()), data.second);
+		return JsonParser(text.c_str()).parse();
+	}
+}
@@ -1,8 +1,15 @@
-#version 400
+#version 450
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
 
+// 0: vertex color, 1: luminance
+layout(constant_id = 0) const int colorMode = 0;
+
 layout(location = 0) in vec4 color;
 layout(location = 0) out vec4 color_out;
 
-void main() { color_out = color; }
+void main()
+{
+	if (colorMode == 1) color_out = vec4(vec3(dot(color.rgb, vec3(0.299f, 0.587f, 0.114f))), color.a);
+	else color_out = color;
+}
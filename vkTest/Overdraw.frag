@@ -0,0 +1,15 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+// Overdraw visualization: drawn with additive blending, every fragment adds 1/saturationLayers
+// so the brightness counts how many times a pixel was shaded(white = saturationLayers or more)
+layout(constant_id = 0) const int saturationLayers = 8;
+
+layout(location = 0) in vec4 color;
+layout(location = 0) out vec4 color_out;
+
+void main()
+{
+	color_out = vec4(vec3(1.0f / float(saturationLayers)), 1.0f);
+}
@@ -1,7 +1,9 @@
-#version 400
+#version 450
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
 
+layout(constant_id = 0) const bool flipY = false;
+
 layout(location = 0) in vec2 pos;
 layout(location = 1) in vec4 color;
 
@@ -10,6 +12,6 @@ out gl_PerVertex { vec4 gl_Position; };
 
 void main()
 {
-	gl_Position = vec4(pos, 0.0f, 1.0f);
+	gl_Position = vec4(flipY ? vec2(pos.x, -pos.y) : pos, 0.0f, 1.0f);
 	color_out = color;
 }
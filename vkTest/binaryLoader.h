@@ -4,22 +4,50 @@
 #include <tuple>
 #include <memory>
 #include <string>
+#include <stdexcept>
 
 namespace BinaryLoader
 {
 	using Data = std::pair<std::unique_ptr<unsigned char[]>, size_t>;
 
-	auto load(const std::wstring& path)
+	using File = std::unique_ptr<FILE, int(*)(FILE*)>;
+
+	// Opens a file for streamed reading
+	auto open(const std::wstring& path)
 	{
 		FILE* fp;
+#ifdef _WIN32
 		if (_wfopen_s(&fp, path.c_str(), L"rb") != 0) throw std::runtime_error("File not found");
+#else
+		// Paths used by this program are ASCII
+		std::string narrowPath(path.size(), '\0');
+		for (size_t i = 0; i < path.size(); i++) narrowPath[i] = static_cast<char>(path[i]);
+		fp = fopen(narrowPath.c_str(), "rb");
+		if (fp == nullptr) throw std::runtime_error("File not found");
+#endif
+		return File(fp, &fclose);
+	}
+	// Opens a file for writing(mode: "wb", "w", "ab"...)
+	auto openForWrite(const std::string& path, const char* mode = "wb")
+	{
+		FILE* fp;
+#ifdef _WIN32
+		if (fopen_s(&fp, path.c_str(), mode) != 0) throw std::runtime_error("Cannot open " + path);
+#else
+		fp = fopen(path.c_str(), mode);
+		if (fp == nullptr) throw std::runtime_error("Cannot open " + path);
+#endif
+		return File(fp, &fclose);
+	}
+	auto load(const std::wstring& path)
+	{
+		auto fp = open(path);
 
-		fseek(fp, 0, SEEK_END);
-		auto size = ftell(fp);
-		fseek(fp, 0, SEEK_SET);
+		fseek(fp.get(), 0, SEEK_END);
+		auto size = ftell(fp.get());
+		fseek(fp.get(), 0, SEEK_SET);
 		auto buf = std::make_unique<unsigned char[]>(size);
-		fread(buf.get(), sizeof(unsigned char), size, fp);
-		fclose(fp);
+		fread(buf.get(), sizeof(unsigned char), size, fp.get());
 		return Data(std::move(buf), size);
 	}
 }
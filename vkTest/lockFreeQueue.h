@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+namespace LockFree
+{
+	// Bounded Multi-Producer Multi-Consumer Queue(sequence-numbered ring buffer)
+	// push/pop never blocks: push fails when full, pop fails when empty.
+	template<typename ElementT, size_t Capacity> class BoundedQueue final
+	{
+		static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+
+		struct Cell
+		{
+			std::atomic<size_t> sequence;
+			ElementT data;
+		};
+		std::unique_ptr<Cell[]> cells;
+		alignas(64) std::atomic<size_t> enqueuePos;
+		alignas(64) std::atomic<size_t> dequeuePos;
+	public:
+		BoundedQueue() : cells(std::make_unique<Cell[]>(Capacity)), enqueuePos(0), dequeuePos(0)
+		{
+			for (size_t i = 0; i < Capacity; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		BoundedQueue(const BoundedQueue&) = delete;
+
+		// Emplaces an element by calling writer(ElementT&) on a reserved cell
+		template<typename WriterT> bool pushWith(WriterT&& writer)
+		{
+			auto pos = this->enqueuePos.load(std::memory_order_relaxed);
+			Cell* cell;
+			for (;;)
+			{
+				cell = &this->cells[pos & (Capacity - 1)];
+				auto seq = cell->sequence.load(std::memory_order_acquire);
+				auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+				if (diff == 0)
+				{
+					if (this->enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+				}
+				else if (diff < 0) return false;
+				else pos = this->enqueuePos.load(std::memory_order_relaxed);
+			}
+			writer(cell->data);
+			cell->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+		bool push(const ElementT& e) { return this->pushWith([&](ElementT& d) { d = e; }); }
+		bool push(ElementT&& e) { return this->pushWith([&](ElementT& d) { d = std::move(e); }); }
+
+		bool pop(ElementT& out)
+		{
+			auto pos = this->dequeuePos.load(std::memory_order_relaxed);
+			Cell* cell;
+			for (;;)
+			{
+				cell = &this->cells[pos & (Capacity - 1)];
+				auto seq = cell->sequence.load(std::memory_order_acquire);
+				auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+				if (diff == 0)
+				{
+					if (this->dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+				}
+				else if (diff < 0) return false;
+				else pos = this->dequeuePos.load(std::memory_order_relaxed);
+			}
+			out = std::move(cell->data);
+			cell->sequence.store(pos + Capacity, std::memory_order_release);
+			return true;
+		}
+	};
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cwchar>
+
+#include "lockFreeQueue.h"
+
+#ifndef _WIN32
+// Debug output goes to stderr outside of Windows.
+// Wide text is narrowed first: once a wide write made stderr wide oriented, every later fputs would be dropped.
+inline void OutputDebugStringA(const char* text) { fputs(text, stderr); }
+inline void OutputDebugString(const wchar_t* text)
+{
+	char buffer[256];
+	auto state = std::mbstate_t();
+	while (text != nullptr && *text != 0)
+	{
+		const auto length = wcsrtombs(buffer, &text, sizeof(buffer) - 1, &state);
+		if (length == static_cast<size_t>(-1))
+		{
+			// not representable in the current locale
+			fputc('?', stderr);
+			text++;
+			state = std::mbstate_t();
+			continue;
+		}
+		buffer[length] = 0;
+		fputs(buffer, stderr);
+	}
+}
+#endif
+
+namespace Platform
+{
+	// Window system events forwarded from the message pump thread to the render thread
+	enum class EventType : uint8_t { Resize, Close, KeyDown, KeyUp, MouseMove };
+	struct Event
+	{
+		EventType type;
+		int32_t x, y;
+		uint32_t code;
+	};
+	// Events are dropped when the render thread falls 1024 events behind
+	using EventQueue = LockFree::BoundedQueue<Event, 1024>;
+
+	// Frame Pacer: sleeps until the next frame deadline and keeps frame time statistics
+	class FramePacer final
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+		struct Statistics
+		{
+			uint64_t frames;
+			double minMilliseconds, averageMilliseconds, maxMilliseconds;
+		};
+	private:
+		Clock::duration interval;
+		Clock::time_point deadline, lastFrame;
+		uint64_t frames;
+		Clock::duration minFrame, maxFrame, totalFrame;
+	public:
+		// targetFps = 0 disables pacing(statistics only)
+		FramePacer(uint32_t targetFps = 0)
+			: interval(targetFps == 0 ? Clock::duration::zero() : std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps))),
+			deadline(Clock::now()), lastFrame(Clock::now()), frames(0),
+			minFrame(Clock::duration::max()), maxFrame(Clock::duration::zero()), totalFrame(Clock::duration::zero()) {}
+
+		// Called once per frame after presentation
+		void endFrame()
+		{
+			if (this->interval != Clock::duration::zero())
+			{
+				this->deadline += this->interval;
+				const auto now = Clock::now();
+				// Do not try to catch up after a long stall
+				if (this->deadline < now) this->deadline = now;
+				else std::this_thread::sleep_until(this->deadline);
+			}
+			const auto now = Clock::now();
+			const auto frameTime = now - this->lastFrame;
+			this->lastFrame = now;
+			this->frames++;
+			this->minFrame = std::min(this->minFrame, frameTime);
+			this->maxFrame = std::max(this->maxFrame, frameTime);
+			this->totalFrame += frameTime;
+		}
+		void reset()
+		{
+			this->deadline = this->lastFrame = Clock::now();
+			this->frames = 0;
+			this->minFrame = Clock::duration::max();
+			this->maxFrame = this->totalFrame = Clock::duration::zero();
+		}
+
+		auto statistics() const
+		{
+			using ms = std::chrono::duration<double, std::milli>;
+			if (this->frames == 0) return Statistics{ 0, 0.0, 0.0, 0.0 };
+			return Statistics
+			{
+				this->frames, ms(this->minFrame).count(), ms(this->totalFrame).count() / static_cast<double>(this->frames), ms(this->maxFrame).count()
+			};
+		}
+	};
+}
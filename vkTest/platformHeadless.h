@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <condition_variable>
+
+#include "platform.h"
+#include "vkDevice.h"
+
+namespace Platform
+{
+	// Headless backend: no window system and no surface.
+	// The render thread draws into offscreen images; runEventLoop just waits for it to finish.
+	class HeadlessBackend final
+	{
+		std::mutex lock;
+		std::condition_variable closed;
+		bool closeRequested;
+	public:
+		HeadlessBackend() : closeRequested(false) {}
+		HeadlessBackend(const HeadlessBackend&) = delete;
+
+		static auto instanceExtensions() { return std::vector<const char*>(); }
+		bool presentable() const { return false; }
+		Vulkan::Surface createSurface(const Vulkan::Instance&) { throw std::logic_error("Headless backend has no surface"); }
+
+		void show() {}
+		int runEventLoop(EventQueue& events)
+		{
+			std::unique_lock<std::mutex> l(this->lock);
+			this->closed.wait(l, [this]() { return this->closeRequested; });
+			events.push(Event{ EventType::Close, 0, 0, 0 });
+			return 0;
+		}
+		void requestClose()
+		{
+			std::lock_guard<std::mutex> l(this->lock);
+			this->closeRequested = true;
+			this->closed.notify_all();
+		}
+	};
+}
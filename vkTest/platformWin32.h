@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <stdexcept>
+
+#include "platform.h"
+#include "vkDevice.h"
+
+namespace Platform
+{
+	// Win32 window backend
+	// The message pump runs on the main thread and only forwards events; rendering never happens inside WndProc.
+	// Closing the window only asks the render thread to stop: the HWND is destroyed after the render thread has released
+	// the swapchain and surface and called requestClose.
+	class Win32Window final
+	{
+		HINSTANCE hInstance;
+		HWND hWnd;
+		int nCmdShow;
+		EventQueue* events;
+		std::atomic<bool> renderFinished;
+
+		void post(EventType type, int32_t x, int32_t y, uint32_t code)
+		{
+			if (this->events != nullptr) this->events->push(Event{ type, x, y, code });
+		}
+		static LRESULT CALLBACK WndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
+		{
+			auto self = reinterpret_cast<Win32Window*>(GetWindowLongPtr(hWnd, GWLP_USERDATA));
+			if (self != nullptr)
+			{
+				switch (uMsg)
+				{
+				case WM_SIZE: self->post(EventType::Resize, LOWORD(lParam), HIWORD(lParam), 0); break;
+				case WM_KEYDOWN: self->post(EventType::KeyDown, 0, 0, static_cast<uint32_t>(wParam)); break;
+				case WM_KEYUP: self->post(EventType::KeyUp, 0, 0, static_cast<uint32_t>(wParam)); break;
+				case WM_MOUSEMOVE: self->post(EventType::MouseMove, static_cast<int16_t>(LOWORD(lParam)), static_cast<int16_t>(HIWORD(lParam)), 0); break;
+				case WM_CLOSE:
+					if (!self->renderFinished.load(std::memory_order_acquire))
+					{
+						self->post(EventType::Close, 0, 0, 0);
+						return 0;
+					}
+					break;
+				case WM_DESTROY: PostQuitMessage(0); break;
+				}
+			}
+			switch (uMsg)
+			{
+			case WM_PAINT:
+				// Presentation is driven by the render thread
+				ValidateRect(hWnd, nullptr);
+				return 0;
+			}
+			return DefWindowProc(hWnd, uMsg, wParam, lParam);
+		}
+	public:
+		Win32Window(HINSTANCE hInstance, int nCmdShow, uint32_t width, uint32_t height)
+			: hInstance(hInstance), hWnd(nullptr), nCmdShow(nCmdShow), events(nullptr), renderFinished(false)
+		{
+			WNDCLASSEX wce{};
+
+			wce.cbSize = sizeof wce;
+			wce.hInstance = hInstance;
+			wce.lpszClassName = L"com.cterm2.vkTest.AppFrame";
+			wce.lpfnWndProc = &WndProc;
+			wce.style = CS_OWNDC;
+			wce.hCursor = LoadCursor(nullptr, IDC_ARROW);
+			if (!RegisterClassEx(&wce)) throw std::runtime_error("RegisterClassEx failed");
+
+			RECT rc;
+			SetRect(&rc, 0, 0, width, height);
+			AdjustWindowRectEx(&rc, WS_OVERLAPPEDWINDOW, false, 0);
+			this->hWnd = CreateWindowEx(0, wce.lpszClassName, L"vkTest", WS_OVERLAPPEDWINDOW,
+				CW_USEDEFAULT, CW_USEDEFAULT, rc.right - rc.left, rc.bottom - rc.top, nullptr, nullptr, hInstance, nullptr);
+			if (this->hWnd == nullptr) throw std::runtime_error("CreateWindowEx failed");
+			SetWindowLongPtr(this->hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+		}
+		Win32Window(const Win32Window&) = delete;
+
+		static auto instanceExtensions() { return std::vector<const char*>{ "VK_KHR_surface", "VK_KHR_win32_surface" }; }
+		bool presentable() const { return true; }
+		auto createSurface(const Vulkan::Instance& instance)
+		{
+			VkWin32SurfaceCreateInfoKHR surfaceInfo{};
+
+			surfaceInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
+			surfaceInfo.hinstance = this->hInstance;
+			surfaceInfo.hwnd = this->hWnd;
+
+			VkSurfaceKHR surface;
+			auto res = vkCreateWin32SurfaceKHR(instance.get(), &surfaceInfo, instance.allocationCallbacks(), &surface);
+			Vulkan::checkError(res);
+			return Vulkan::Surface(instance.get(), surface, &vkDestroySurfaceKHR, instance.allocationCallbacks());
+		}
+
+		void show() { ShowWindow(this->hWnd, this->nCmdShow); }
+		// Pumps messages until the window is destroyed
+		int runEventLoop(EventQueue& events)
+		{
+			this->events = &events;
+			MSG msg;
+			while (GetMessage(&msg, nullptr, 0, 0) > 0)
+			{
+				TranslateMessage(&msg);
+				DispatchMessage(&msg);
+			}
+			this->events = nullptr;
+			return static_cast<int>(msg.wParam);
+		}
+		// Callable from any thread; called by the render thread once it no longer uses the window
+		void requestClose()
+		{
+			this->renderFinished.store(true, std::memory_order_release);
+			PostMessage(this->hWnd, WM_CLOSE, 0, 0);
+		}
+	};
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include <xcb/xcb.h>
+
+#include "platform.h"
+#include "vkDevice.h"
+
+namespace Platform
+{
+	// XCB window backend(Linux)
+	// The event loop blocks in xcb_wait_for_event on the main thread; requestClose wakes it with a client message.
+	class XcbWindow final
+	{
+		xcb_connection_t* connection;
+		xcb_screen_t* screen;
+		xcb_window_t window;
+		xcb_atom_t protocolsAtom, deleteWindowAtom;
+		uint32_t width, height;
+
+		auto internAtom(const char* name)
+		{
+			auto cookie = xcb_intern_atom(this->connection, 0, static_cast<uint16_t>(strlen(name)), name);
+			auto reply = xcb_intern_atom_reply(this->connection, cookie, nullptr);
+			if (reply == nullptr) return static_cast<xcb_atom_t>(XCB_ATOM_NONE);
+			const auto atom = reply->atom;
+			free(reply);
+			return atom;
+		}
+	public:
+		XcbWindow(uint32_t width, uint32_t height) : width(width), height(height)
+		{
+			int screenIndex;
+			this->connection = xcb_connect(nullptr, &screenIndex);
+			if (xcb_connection_has_error(this->connection))
+			{
+				xcb_disconnect(this->connection);
+				throw std::runtime_error("Cannot connect to the X server");
+			}
+			auto iter = xcb_setup_roots_iterator(xcb_get_setup(this->connection));
+			while (screenIndex-- > 0) xcb_screen_next(&iter);
+			this->screen = iter.data;
+
+			this->window = xcb_generate_id(this->connection);
+			const uint32_t valueMask = XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK;
+			const uint32_t values[] =
+			{
+				this->screen->black_pixel,
+				XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE | XCB_EVENT_MASK_POINTER_MOTION | XCB_EVENT_MASK_STRUCTURE_NOTIFY
+			};
+			xcb_create_window(this->connection, XCB_COPY_FROM_PARENT, this->window, this->screen->root, 0, 0,
+				static_cast<uint16_t>(width), static_cast<uint16_t>(height), 0,
+				XCB_WINDOW_CLASS_INPUT_OUTPUT, this->screen->root_visual, valueMask, values);
+			xcb_change_property(this->connection, XCB_PROP_MODE_REPLACE, this->window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, 6, "vkTest");
+
+			// Receive WM_DELETE_WINDOW instead of being killed by the window manager
+			this->protocolsAtom = this->internAtom("WM_PROTOCOLS");
+			this->deleteWindowAtom = this->internAtom("WM_DELETE_WINDOW");
+			xcb_change_property(this->connection, XCB_PROP_MODE_REPLACE, this->window, this->protocolsAtom, XCB_ATOM_ATOM, 32, 1, &this->deleteWindowAtom);
+		}
+		XcbWindow(const XcbWindow&) = delete;
+		~XcbWindow()
+		{
+			xcb_destroy_window(this->connection, this->window);
+			xcb_disconnect(this->connection);
+		}
+
+		static auto instanceExtensions() { return std::vector<const char*>{ "VK_KHR_surface", "VK_KHR_xcb_surface" }; }
+		bool presentable() const { return true; }
+		auto createSurface(const Vulkan::Instance& instance)
+		{
+			VkXcbSurfaceCreateInfoKHR surfaceInfo{};
+
+			surfaceInfo.sType = VK_STRUCTURE_TYPE_XCB_SURFACE_CREATE_INFO_KHR;
+			surfaceInfo.connection = this->connection;
+			surfaceInfo.window = this->window;
+
+			VkSurfaceKHR surface;
+			auto res = vkCreateXcbSurfaceKHR(instance.get(), &surfaceInfo, instance.allocationCallbacks(), &surface);
+			Vulkan::checkError(res);
+			return Vulkan::Surface(instance.get(), surface, &vkDestroySurfaceKHR, instance.allocationCallbacks());
+		}
+
+		void show()
+		{
+			xcb_map_window(this->connection, this->window);
+			xcb_flush(this->connection);
+		}
+		// Dispatches events until the window is closed
+		int runEventLoop(EventQueue& events)
+		{
+			xcb_generic_event_t* e;
+			bool closed = false;
+			while (!closed && (e = xcb_wait_for_event(this->connection)) != nullptr)
+			{
+				switch (e->response_type & 0x7f)
+				{
+				case XCB_CONFIGURE_NOTIFY:
+				{
+					auto cfg = reinterpret_cast<xcb_configure_notify_event_t*>(e);
+					if (cfg->width != this->width || cfg->height != this->height)
+					{
+						this->width = cfg->width;
+						this->height = cfg->height;
+						events.push(Event{ EventType::Resize, static_cast<int32_t>(cfg->width), static_cast<int32_t>(cfg->height), 0 });
+					}
+					break;
+				}
+				case XCB_KEY_PRESS: events.push(Event{ EventType::KeyDown, 0, 0, reinterpret_cast<xcb_key_press_event_t*>(e)->detail }); break;
+				case XCB_KEY_RELEASE: events.push(Event{ EventType::KeyUp, 0, 0, reinterpret_cast<xcb_key_release_event_t*>(e)->detail }); break;
+				case XCB_MOTION_NOTIFY:
+				{
+					auto motion = reinterpret_cast<xcb_motion_notify_event_t*>(e);
+					events.push(Event{ EventType::MouseMove, motion->event_x, motion->event_y, 0 });
+					break;
+				}
+				case XCB_CLIENT_MESSAGE:
+					if (reinterpret_cast<xcb_client_message_event_t*>(e)->data.data32[0] == this->deleteWindowAtom)
+					{
+						events.push(Event{ EventType::Close, 0, 0, 0 });
+						closed = true;
+					}
+					break;
+				}
+				free(e);
+			}
+			// Connection lost(xcb_wait_for_event returned nullptr): the render thread still has to stop
+			if (!closed) events.push(Event{ EventType::Close, 0, 0, 0 });
+			return 0;
+		}
+		// Callable from any thread: sends WM_DELETE_WINDOW to ourselves
+		void requestClose()
+		{
+			xcb_client_message_event_t msg{};
+			msg.response_type = XCB_CLIENT_MESSAGE;
+			msg.format = 32;
+			msg.window = this->window;
+			msg.type = this->protocolsAtom;
+			msg.data.data32[0] = this->deleteWindowAtom;
+			xcb_send_event(this->connection, 0, this->window, XCB_EVENT_MASK_NO_EVENT, reinterpret_cast<const char*>(&msg));
+			xcb_flush(this->connection);
+		}
+	};
+}
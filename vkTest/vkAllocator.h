@@ -0,0 +1,260 @@
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <algorithm>
+
+namespace Vulkan
+{
+	// Host Allocator with per-scope statistics
+	// VK_SYSTEM_ALLOCATION_SCOPE_COMMAND allocations are served from a per-thread bump arena
+	// which is rewound at the first allocation after beginFrame() once all of its blocks are freed.
+	// Arenas belong to the allocator(claimed by the first MaxArenas threads, released with it), so blocks outlive the threads
+	// that allocated them; further threads use the heap.
+	class TrackingAllocator final
+	{
+	public:
+		static constexpr size_t ScopeCount = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;		// *_RANGE_SIZE is gone from current headers
+		static constexpr size_t ArenaCapacity = 256 * 1024;
+		static constexpr size_t MaxArenas = 16;
+
+		struct ScopeStatistics
+		{
+			size_t liveBytes, peakBytes, liveAllocations, totalAllocations;
+		};
+		struct Statistics
+		{
+			ScopeStatistics scopes[ScopeCount];
+			size_t liveBytes, peakBytes, internalBytes;
+			size_t arenaAllocations, arenaFallbacks, arenaResets;
+		};
+	private:
+		struct ScopeCounters
+		{
+			std::atomic<size_t> liveBytes{ 0 }, peakBytes{ 0 }, liveAllocations{ 0 }, totalAllocations{ 0 };
+		};
+		struct FrameArena
+		{
+			std::unique_ptr<uint8_t[]> block;
+			size_t used = 0;
+			std::atomic<size_t> liveAllocations{ 0 };
+			std::atomic<std::thread::id> thread{ std::thread::id() };		// default id: unclaimed
+			uint64_t epoch = 0;
+		};
+		// Placed just before every returned pointer
+		struct Header
+		{
+			size_t size;
+			FrameArena* arena;	// nullptr for heap blocks
+			uint32_t offset;	// distance from raw block(or arena slot) head
+			uint8_t scope;
+		};
+
+		ScopeCounters scopes[ScopeCount];
+		std::atomic<size_t> liveBytes{ 0 }, peakBytes{ 0 }, internalBytes{ 0 };
+		std::atomic<size_t> arenaAllocations{ 0 }, arenaFallbacks{ 0 }, arenaResets{ 0 };
+		std::atomic<uint64_t> frameEpoch{ 1 };
+		const uint64_t id;		// distinguishes allocators that reuse an address
+		FrameArena arenas[MaxArenas];
+		VkAllocationCallbacks callbacks;
+
+		static uint64_t nextId()
+		{
+			static std::atomic<uint64_t> counter{ 0 };
+			return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+		}
+		// Arena claimed by the calling thread(nullptr when all of them are taken by other threads)
+		FrameArena* threadArena()
+		{
+			struct Binding { uint64_t allocator; FrameArena* arena; };
+			thread_local Binding cached{ 0, nullptr };
+			if (cached.allocator == this->id) return cached.arena;
+
+			const auto self = std::this_thread::get_id();
+			FrameArena* found = nullptr;
+			for (auto& a : this->arenas)
+			{
+				if (a.thread.load(std::memory_order_acquire) == self) { found = &a; break; }
+			}
+			for (size_t i = 0; found == nullptr && i < MaxArenas; i++)
+			{
+				auto unclaimed = std::thread::id();
+				if (this->arenas[i].thread.compare_exchange_strong(unclaimed, self, std::memory_order_acq_rel)) found = &this->arenas[i];
+			}
+			cached = Binding{ this->id, found };
+			return found;
+		}
+		static void updatePeak(std::atomic<size_t>& peak, size_t value)
+		{
+			auto current = peak.load(std::memory_order_relaxed);
+			while (current < value && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed));
+		}
+		static auto headerOf(void* p) { return reinterpret_cast<Header*>(reinterpret_cast<uint8_t*>(p) - sizeof(Header)); }
+		static auto alignUp(uintptr_t v, size_t alignment) { return (v + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1); }
+
+		void track(VkSystemAllocationScope scope, size_t size)
+		{
+			auto& s = this->scopes[scope];
+			updatePeak(s.peakBytes, s.liveBytes.fetch_add(size, std::memory_order_relaxed) + size);
+			s.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+			s.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+			updatePeak(this->peakBytes, this->liveBytes.fetch_add(size, std::memory_order_relaxed) + size);
+		}
+		void untrack(VkSystemAllocationScope scope, size_t size)
+		{
+			auto& s = this->scopes[scope];
+			s.liveBytes.fetch_sub(size, std::memory_order_relaxed);
+			s.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+			this->liveBytes.fetch_sub(size, std::memory_order_relaxed);
+		}
+
+		void* allocateFromArena(size_t size, size_t alignment)
+		{
+			const auto pArena = this->threadArena();
+			if (pArena == nullptr) return nullptr;
+			auto& arena = *pArena;
+			const auto epoch = this->frameEpoch.load(std::memory_order_relaxed);
+			if (arena.epoch != epoch && arena.liveAllocations.load(std::memory_order_acquire) == 0)
+			{
+				if (arena.used > 0) this->arenaResets.fetch_add(1, std::memory_order_relaxed);
+				arena.used = 0;
+				arena.epoch = epoch;
+			}
+			if (!arena.block) arena.block = std::make_unique<uint8_t[]>(ArenaCapacity);
+
+			const auto base = reinterpret_cast<uintptr_t>(arena.block.get());
+			const auto head = base + arena.used;
+			const auto user = alignUp(head + sizeof(Header), alignment);
+			if (user + size > base + ArenaCapacity) return nullptr;
+
+			auto header = reinterpret_cast<Header*>(user - sizeof(Header));
+			header->size = size;
+			header->offset = static_cast<uint32_t>(user - head);
+			header->scope = VK_SYSTEM_ALLOCATION_SCOPE_COMMAND;
+			header->arena = &arena;
+			arena.used = user + size - base;
+			arena.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+			this->arenaAllocations.fetch_add(1, std::memory_order_relaxed);
+			return reinterpret_cast<void*>(user);
+		}
+		void* allocateFromHeap(size_t size, size_t alignment, VkSystemAllocationScope scope)
+		{
+			auto raw = reinterpret_cast<uint8_t*>(malloc(size + alignment + sizeof(Header)));
+			if (raw == nullptr) return nullptr;
+			const auto user = alignUp(reinterpret_cast<uintptr_t>(raw) + sizeof(Header), alignment);
+
+			auto header = reinterpret_cast<Header*>(user - sizeof(Header));
+			header->size = size;
+			header->offset = static_cast<uint32_t>(user - reinterpret_cast<uintptr_t>(raw));
+			header->scope = static_cast<uint8_t>(scope);
+			header->arena = nullptr;
+			return reinterpret_cast<void*>(user);
+		}
+		void* allocate(size_t size, size_t alignment, VkSystemAllocationScope scope)
+		{
+			if (size == 0) return nullptr;
+			alignment = std::max(alignment, alignof(Header));
+
+			void* p = nullptr;
+			if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND)
+			{
+				p = this->allocateFromArena(size, alignment);
+				if (p == nullptr) this->arenaFallbacks.fetch_add(1, std::memory_order_relaxed);
+			}
+			if (p == nullptr) p = this->allocateFromHeap(size, alignment, scope);
+			if (p != nullptr) this->track(scope, size);
+			return p;
+		}
+		void release(void* p)
+		{
+			if (p == nullptr) return;
+			auto header = headerOf(p);
+			this->untrack(static_cast<VkSystemAllocationScope>(header->scope), header->size);
+			if (header->arena != nullptr)
+			{
+				// Arena blocks are reclaimed in bulk by the owning thread(the arena itself lives as long as the allocator)
+				header->arena->liveAllocations.fetch_sub(1, std::memory_order_release);
+			}
+			else free(reinterpret_cast<uint8_t*>(p) - header->offset);
+		}
+		void* reallocate(void* original, size_t size, size_t alignment, VkSystemAllocationScope scope)
+		{
+			if (original == nullptr) return this->allocate(size, alignment, scope);
+			if (size == 0)
+			{
+				this->release(original);
+				return nullptr;
+			}
+			const auto oldSize = headerOf(original)->size;
+			auto p = this->allocate(size, alignment, scope);
+			if (p == nullptr) return nullptr;
+			memcpy(p, original, std::min(oldSize, size));
+			this->release(original);
+			return p;
+		}
+
+		static VKAPI_ATTR void* VKAPI_CALL allocationFunc(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope scope)
+		{
+			return reinterpret_cast<TrackingAllocator*>(pUserData)->allocate(size, alignment, scope);
+		}
+		static VKAPI_ATTR void* VKAPI_CALL reallocationFunc(void* pUserData, void* pOriginal, size_t size, size_t alignment, VkSystemAllocationScope scope)
+		{
+			return reinterpret_cast<TrackingAllocator*>(pUserData)->reallocate(pOriginal, size, alignment, scope);
+		}
+		static VKAPI_ATTR void VKAPI_CALL freeFunc(void* pUserData, void* pMemory)
+		{
+			reinterpret_cast<TrackingAllocator*>(pUserData)->release(pMemory);
+		}
+		static VKAPI_ATTR void VKAPI_CALL internalAllocationNotification(void* pUserData, size_t size, VkInternalAllocationType, VkSystemAllocationScope)
+		{
+			reinterpret_cast<TrackingAllocator*>(pUserData)->internalBytes.fetch_add(size, std::memory_order_relaxed);
+		}
+		static VKAPI_ATTR void VKAPI_CALL internalFreeNotification(void* pUserData, size_t size, VkInternalAllocationType, VkSystemAllocationScope)
+		{
+			reinterpret_cast<TrackingAllocator*>(pUserData)->internalBytes.fetch_sub(size, std::memory_order_relaxed);
+		}
+	public:
+		TrackingAllocator() : id(nextId()), callbacks{}
+		{
+			this->callbacks.pUserData = this;
+			this->callbacks.pfnAllocation = &allocationFunc;
+			this->callbacks.pfnReallocation = &reallocationFunc;
+			this->callbacks.pfnFree = &freeFunc;
+			this->callbacks.pfnInternalAllocation = &internalAllocationNotification;
+			this->callbacks.pfnInternalFree = &internalFreeNotification;
+		}
+		TrackingAllocator(const TrackingAllocator&) = delete;
+
+		auto get() const noexcept { return &this->callbacks; }
+		// Marks a frame boundary: command scope arenas are rewound lazily by each thread
+		void beginFrame() { this->frameEpoch.fetch_add(1, std::memory_order_relaxed); }
+
+		auto statistics() const
+		{
+			Statistics stats{};
+			for (size_t i = 0; i < ScopeCount; i++)
+			{
+				stats.scopes[i] = ScopeStatistics
+				{
+					this->scopes[i].liveBytes.load(std::memory_order_relaxed), this->scopes[i].peakBytes.load(std::memory_order_relaxed),
+					this->scopes[i].liveAllocations.load(std::memory_order_relaxed), this->scopes[i].totalAllocations.load(std::memory_order_relaxed)
+				};
+			}
+			stats.liveBytes = this->liveBytes.load(std::memory_order_relaxed);
+			stats.peakBytes = this->peakBytes.load(std::memory_order_relaxed);
+			stats.internalBytes = this->internalBytes.load(std::memory_order_relaxed);
+			stats.arenaAllocations = this->arenaAllocations.load(std::memory_order_relaxed);
+			stats.arenaFallbacks = this->arenaFallbacks.load(std::memory_order_relaxed);
+			stats.arenaResets = this->arenaResets.load(std::memory_order_relaxed);
+			return stats;
+		}
+		static auto scopeName(size_t scope)
+		{
+			static const char* names[] = { "command", "object", "cache", "device", "instance" };
+			return scope < ScopeCount ? names[scope] : "unknown";
+		}
+	};
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+#include "lockFreeQueue.h"
+#include "platform.h"
+
+namespace Vulkan
+{
+	// Debug Report messages are copied into a bounded lock-free ring buffer by the callback
+	// and formatted/written by a background thread, so that the calling thread never blocks on output.
+	// Repeats of a messageCode are deduplicated in the callback before rate limiting, so one noisy message cannot use up the budget.
+	class DebugReportLogger final
+	{
+	public:
+		struct Message
+		{
+			VkDebugReportFlagsEXT flags;
+			int32_t messageCode;
+			uint32_t repeats;		// suppressed since the last emission of messageCode
+			char layerPrefix[16];
+			char text[484];
+		};
+		struct Statistics
+		{
+			uint32_t posted, dropped, rateLimited, suppressed;
+		};
+	private:
+		using Clock = std::chrono::steady_clock;
+		static constexpr uint32_t DedupSlots = 64, DedupProbes = 4;
+		static constexpr int64_t EmptySlot = INT64_MIN;
+		// Open addressed over DedupProbes consecutive slots; a slot idle for dedupInterval with no pending repeats can be reclaimed
+		struct DedupSlot
+		{
+			std::atomic<int64_t> messageCode;
+			std::atomic<int64_t> lastEmitted;		// Clock ticks
+			std::atomic<uint32_t> suppressedCount;
+		};
+
+		LockFree::BoundedQueue<Message, 256> queue;
+		const uint32_t maxMessagesPerSecond;
+		const Clock::duration dedupInterval;
+		std::atomic<int64_t> rateWindow;
+		std::atomic<uint32_t> rateWindowCount;
+		std::atomic<uint32_t> postedCount, droppedCount, rateLimitedCount, suppressedCount;
+		std::atomic<bool> running;
+		DedupSlot dedupTable[DedupSlots];
+		std::thread worker;
+
+		static void output(const char* text) { OutputDebugStringA(text); }
+		template<size_t N> static void copyTruncated(char (&dst)[N], const char* src)
+		{
+			const auto length = src != nullptr ? std::min(strlen(src), N - 1) : 0;
+			if (length > 0) memcpy(dst, src, length);
+			dst[length] = 0;
+		}
+		static std::string repeatedLine(int32_t messageCode, uint32_t repeats)
+		{
+			return "Vulkan DebugCall (" + std::to_string(messageCode) + "): +" + std::to_string(repeats) + " similar suppressed\n";
+		}
+		static const char* severityLabel(VkDebugReportFlagsEXT flags)
+		{
+			if ((flags & VK_DEBUG_REPORT_ERROR_BIT_EXT) != 0) return "Error";
+			if ((flags & VK_DEBUG_REPORT_WARNING_BIT_EXT) != 0) return "Warning";
+			if ((flags & VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT) != 0) return "PerfWarning";
+			if ((flags & VK_DEBUG_REPORT_INFORMATION_BIT_EXT) != 0) return "Info";
+			return "Debug";
+		}
+
+		// Slot owned or newly claimed by messageCode(nullptr if every probed slot is busy with another code)
+		DedupSlot* findDedupSlot(int32_t messageCode, int64_t now)
+		{
+			const auto home = static_cast<uint32_t>(messageCode) % DedupSlots;
+			DedupSlot* stale = nullptr;
+			int64_t staleOwner = EmptySlot;
+			for (uint32_t i = 0; i < DedupProbes; i++)
+			{
+				auto& slot = this->dedupTable[(home + i) % DedupSlots];
+				auto owner = slot.messageCode.load(std::memory_order_acquire);
+				// slots are never emptied again, so messageCode cannot live past the first empty one
+				if (owner == EmptySlot && slot.messageCode.compare_exchange_strong(owner, messageCode, std::memory_order_acq_rel)) return &slot;
+				if (owner == messageCode) return &slot;
+
+				const auto last = slot.lastEmitted.load(std::memory_order_relaxed);
+				if (stale == nullptr && last != EmptySlot && now - last >= this->dedupInterval.count() && slot.suppressedCount.load(std::memory_order_relaxed) == 0)
+				{
+					stale = &slot;
+					staleOwner = owner;
+				}
+			}
+			if (stale == nullptr || !stale->messageCode.compare_exchange_strong(staleOwner, messageCode, std::memory_order_acq_rel)) return nullptr;
+			stale->lastEmitted.store(EmptySlot, std::memory_order_relaxed);
+			return stale;
+		}
+		// false if messageCode was emitted within dedupInterval(the repeat is counted instead); repeats receives the count to report
+		bool acquireDedup(int32_t messageCode, uint32_t& repeats)
+		{
+			repeats = 0;
+			const auto now = Clock::now().time_since_epoch().count();
+			const auto found = this->findDedupSlot(messageCode, now);
+			if (found == nullptr) return true;
+
+			auto& slot = *found;
+			auto last = slot.lastEmitted.load(std::memory_order_relaxed);
+			if (last != EmptySlot && now - last < this->dedupInterval.count()) { slot.suppressedCount.fetch_add(1, std::memory_order_relaxed); return false; }
+			// only one of concurrent posters emits; the others count as repeats
+			if (!slot.lastEmitted.compare_exchange_strong(last, now, std::memory_order_relaxed)) { slot.suppressedCount.fetch_add(1, std::memory_order_relaxed); return false; }
+			repeats = slot.suppressedCount.exchange(0, std::memory_order_relaxed);
+			return true;
+		}
+		// Accept at most maxMessagesPerSecond messages in each 1-second window
+		bool acquireRate()
+		{
+			const auto window = std::chrono::duration_cast<std::chrono::seconds>(Clock::now().time_since_epoch()).count();
+			auto current = this->rateWindow.load(std::memory_order_relaxed);
+			if (current != window && this->rateWindow.compare_exchange_strong(current, window, std::memory_order_relaxed))
+			{
+				this->rateWindowCount.store(0, std::memory_order_relaxed);
+			}
+			return this->rateWindowCount.fetch_add(1, std::memory_order_relaxed) < this->maxMessagesPerSecond;
+		}
+		void workerProc()
+		{
+			Message msg;
+			uint32_t reportedDrops = 0;
+
+			for (;;)
+			{
+				if (!this->queue.pop(msg))
+				{
+					const auto drops = this->droppedCount.load(std::memory_order_relaxed) + this->rateLimitedCount.load(std::memory_order_relaxed);
+					if (drops != reportedDrops)
+					{
+						output(("Vulkan DebugCall: " + std::to_string(drops - reportedDrops) + " messages were dropped or rate-limited\n").c_str());
+						reportedDrops = drops;
+					}
+					if (!this->running.load(std::memory_order_acquire)) break;
+					std::this_thread::sleep_for(std::chrono::milliseconds(4));
+					continue;
+				}
+
+				std::string line = "Vulkan DebugCall [";
+				line += severityLabel(msg.flags);
+				line += "] ";
+				line += msg.layerPrefix;
+				line += "(";
+				line += std::to_string(msg.messageCode);
+				line += "): ";
+				line += msg.text;
+				if (msg.repeats > 0) line += " (+" + std::to_string(msg.repeats) + " similar suppressed)";
+				line += "\n";
+				output(line.c_str());
+			}
+
+			// Trailing repeats that were never followed by another emission
+			for (auto& slot : this->dedupTable)
+			{
+				const auto repeats = slot.suppressedCount.exchange(0, std::memory_order_relaxed);
+				if (repeats > 0) output(repeatedLine(static_cast<int32_t>(slot.messageCode.load(std::memory_order_relaxed)), repeats).c_str());
+			}
+		}
+	public:
+		DebugReportLogger(uint32_t maxMessagesPerSecond = 64, std::chrono::milliseconds dedupInterval = std::chrono::milliseconds(1000))
+			: maxMessagesPerSecond(maxMessagesPerSecond), dedupInterval(dedupInterval), rateWindow(0), rateWindowCount(0),
+			postedCount(0), droppedCount(0), rateLimitedCount(0), suppressedCount(0), running(true)
+		{
+			for (auto& slot : this->dedupTable)
+			{
+				slot.messageCode.store(EmptySlot, std::memory_order_relaxed);
+				slot.lastEmitted.store(EmptySlot, std::memory_order_relaxed);
+				slot.suppressedCount.store(0, std::memory_order_relaxed);
+			}
+			this->worker = std::thread([this]() { this->workerProc(); });
+		}
+		DebugReportLogger(const DebugReportLogger&) = delete;
+		~DebugReportLogger()
+		{
+			this->running.store(false, std::memory_order_release);
+			if (this->worker.joinable()) this->worker.join();
+		}
+
+		// Called from any thread; copies message and returns immediately
+		void post(VkDebugReportFlagsEXT flags, int32_t messageCode, const char* pLayerPrefix, const char* pMessage)
+		{
+			uint32_t repeats;
+			if (!this->acquireDedup(messageCode, repeats))
+			{
+				this->suppressedCount.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			if (!this->acquireRate())
+			{
+				this->rateLimitedCount.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			const auto pushed = this->queue.pushWith([&](Message& m)
+			{
+				m.flags = flags;
+				m.messageCode = messageCode;
+				m.repeats = repeats;
+				copyTruncated(m.layerPrefix, pLayerPrefix);
+				copyTruncated(m.text, pMessage);
+			});
+			if (pushed) this->postedCount.fetch_add(1, std::memory_order_relaxed);
+			else this->droppedCount.fetch_add(1, std::memory_order_relaxed);
+		}
+		auto statistics() const
+		{
+			return Statistics
+			{
+				this->postedCount.load(std::memory_order_relaxed), this->droppedCount.load(std::memory_order_relaxed),
+				this->rateLimitedCount.load(std::memory_order_relaxed), this->suppressedCount.load(std::memory_order_relaxed)
+			};
+		}
+
+		static VKAPI_ATTR VkBool32 VKAPI_CALL callback(VkDebugReportFlagsEXT flags, VkDebugReportObjectTypeEXT, uint64_t,
+			size_t, int32_t messageCode, const char* pLayerPrefix, const char* pMessage, void* pUserData)
+		{
+			reinterpret_cast<DebugReportLogger*>(pUserData)->post(flags, messageCode, pLayerPrefix, pMessage);
+			return VK_FALSE;
+		}
+	};
+}
@@ -0,0 +1,1216 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+#include <iterator>
+#include <functional>
+#include <cstring>
+
+#include "platform.h"
+#include "vkUniqueObjects.h"
+#include "vkDebugReport.h"
+#include "vkAllocator.h"
+#include "vkPipelineState.h"
+#include "vkPipelineStateCache.h"
+#include "vkRenderPass.h"
+#include "binaryLoader.h"
+
+// Debug Layer Extensions
+static PFN_vkCreateDebugReportCallbackEXT	_vkCreateDebugReportCallbackEXT;
+static PFN_vkDebugReportMessageEXT			_vkDebugReportMessageEXT;
+static PFN_vkDestroyDebugReportCallbackEXT	_vkDestroyDebugReportCallbackEXT;
+
+namespace Vulkan
+{
+	void checkError(VkResult res) { if (res != VK_SUCCESS) throw std::runtime_error(std::to_string(res).c_str()); }
+
+	// Runtime Profiles
+	// Release: no layers and no debug report callbacks
+	// Profiling: debug report for performance warnings(and errors) only, no validation layers
+	// Validation: standard validation layers with all messages
+	enum class RuntimeProfile { Release, Profiling, Validation };
+	struct RuntimeProfileDesc
+	{
+		bool enableValidationLayers;
+		bool enableDebugReport;
+		VkDebugReportFlagsEXT debugReportFlags;
+	};
+	auto describeProfile(RuntimeProfile profile)
+	{
+		switch (profile)
+		{
+		case RuntimeProfile::Profiling:
+			return RuntimeProfileDesc{ false, true, VK_DEBUG_REPORT_ERROR_BIT_EXT | VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT };
+		case RuntimeProfile::Validation:
+			return RuntimeProfileDesc{ true, true, VK_DEBUG_REPORT_ERROR_BIT_EXT | VK_DEBUG_REPORT_WARNING_BIT_EXT
+				| VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT | VK_DEBUG_REPORT_INFORMATION_BIT_EXT };
+		default:
+			return RuntimeProfileDesc{ false, false, 0 };
+		}
+	}
+	// Parses "--profile=release|profiling|validation" from command line
+	auto parseRuntimeProfile(const char* cmdLine)
+	{
+#ifdef _DEBUG
+		auto profile = RuntimeProfile::Validation;
+#else
+		auto profile = RuntimeProfile::Release;
+#endif
+		const char* opt = cmdLine != nullptr ? strstr(cmdLine, "--profile=") : nullptr;
+		if (opt == nullptr) return profile;
+		opt += strlen("--profile=");
+		if (strncmp(opt, "release", 7) == 0) profile = RuntimeProfile::Release;
+		else if (strncmp(opt, "profiling", 9) == 0) profile = RuntimeProfile::Profiling;
+		else if (strncmp(opt, "validation", 10) == 0) profile = RuntimeProfile::Validation;
+		return profile;
+	}
+
+	// surfaceExtensions: platform WSI extensions(empty for headless)
+	auto createInstance(RuntimeProfile profile, const std::vector<const char*>& surfaceExtensions, const VkAllocationCallbacks* allocator = nullptr)
+	{
+		const auto profileDesc = describeProfile(profile);
+		VkInstanceCreateInfo instanceInfo{};
+		VkApplicationInfo appInfo{};
+		auto extensions = surfaceExtensions;
+		const char* layers[] = { "VK_LAYER_LUNARG_standard_validation" };
+		if (profileDesc.enableDebugReport) extensions.push_back("VK_EXT_debug_report");
+
+		appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+		appInfo.applicationVersion = VK_MAKE_VERSION(0, 0, 1);
+		appInfo.pApplicationName = "com.cterm2.vkTest";
+		appInfo.apiVersion = VK_API_VERSION;
+		instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+		instanceInfo.pApplicationInfo = &appInfo;
+		instanceInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+		instanceInfo.ppEnabledExtensionNames = extensions.data();
+		instanceInfo.enabledLayerCount = profileDesc.enableValidationLayers ? size(layers) : 0;
+		instanceInfo.ppEnabledLayerNames = layers;
+		
+		VkInstance instance;
+		auto res = vkCreateInstance(&instanceInfo, allocator, &instance);
+		checkError(res);
+
+		// load extensions
+		if (profileDesc.enableDebugReport)
+		{
+			_vkCreateDebugReportCallbackEXT = reinterpret_cast<PFN_vkCreateDebugReportCallbackEXT>(vkGetInstanceProcAddr(instance, "vkCreateDebugReportCallbackEXT"));
+			_vkDebugReportMessageEXT = reinterpret_cast<PFN_vkDebugReportMessageEXT>(vkGetInstanceProcAddr(instance, "vkDebugReportMessageEXT"));
+			_vkDestroyDebugReportCallbackEXT = reinterpret_cast<PFN_vkDestroyDebugReportCallbackEXT>(vkGetInstanceProcAddr(instance, "vkDestroyDebugReportCallbackEXT"));
+		}
+
+		return Instance(instance, &vkDestroyInstance, allocator);
+	}
+	auto createDebugReportCallback(const Instance& instance, RuntimeProfile profile, DebugReportLogger* logger)
+	{
+		const auto profileDesc = describeProfile(profile);
+		if (!profileDesc.enableDebugReport || logger == nullptr) return UniqueObjectWithInstance<VkDebugReportCallbackEXT>();
+
+		VkDebugReportCallbackCreateInfoEXT callbackInfo{};
+		
+		callbackInfo.sType = VK_STRUCTURE_TYPE_DEBUG_REPORT_CALLBACK_CREATE_INFO_EXT;
+		callbackInfo.flags = profileDesc.debugReportFlags;
+		callbackInfo.pfnCallback = &DebugReportLogger::callback;
+		callbackInfo.pUserData = logger;
+		
+		VkDebugReportCallbackEXT callback;
+		auto res = _vkCreateDebugReportCallbackEXT(instance.get(), &callbackInfo, instance.allocationCallbacks(), &callback);
+		checkError(res);
+		return UniqueObjectWithInstance<VkDebugReportCallbackEXT>(instance.get(), callback, _vkDestroyDebugReportCallbackEXT, instance.allocationCallbacks());
+	}
+	auto enumerateAndGetDefaultPhysicalDevice(const Instance& instance)
+	{
+		uint32_t adapterCount;
+		auto res = vkEnumeratePhysicalDevices(instance.get(), &adapterCount, nullptr);
+		checkError(res);
+		auto adapters = std::make_unique<VkPhysicalDevice[]>(adapterCount);
+		res = vkEnumeratePhysicalDevices(instance.get(), &adapterCount, adapters.get());
+		checkError(res);
+		OutputDebugString(L"=== Physical Device Enumeration ===\n");
+		for (uint32_t i = 0; i < adapterCount; i++)
+		{
+			static VkPhysicalDeviceProperties props;
+			static VkPhysicalDeviceMemoryProperties memProps;
+			vkGetPhysicalDeviceProperties(adapters[i], &props);
+			vkGetPhysicalDeviceMemoryProperties(adapters[i], &memProps);
+
+			OutputDebugString(L"#"); OutputDebugString(std::to_wstring(i).c_str()); OutputDebugString(L": \n");
+			OutputDebugString(L"  Name: "); OutputDebugStringA(props.deviceName); OutputDebugString(L"\n");
+			OutputDebugString(L"  API Version: "); OutputDebugString(std::to_wstring(props.apiVersion).c_str()); OutputDebugString(L"\n");
+		}
+		return adapters[0];
+	}
+
+	// Unique Arrays and Paired Structures
+	using ImageArray = UniqueArray<VkImage>;
+	using ImageViewArray = UniqueArray<ImageView>;
+	using FramebufferArray = UniqueArray<Framebuffer>;
+	using BufferData = std::pair<Buffer, DeviceMemory>;
+	using ImageData = std::pair<Image, DeviceMemory>;
+	using ImageDataArray = UniqueArray<ImageData>;
+	// Framebuffers sharing one set of transient attachments(frames are rendered one at a time)
+	struct FramebufferSet
+	{
+		FramebufferArray framebuffers;
+		std::vector<ImageData> transientImages;
+		std::vector<ImageView> transientViews;
+		uint32_t lazilyAllocatedCount;
+	};
+
+	// Raw handle view of owned images(for functions taking swapchain-style ImageArray)
+	auto imageHandles(const ImageDataArray& images)
+	{
+		auto handles = std::make_unique<VkImage[]>(size(images));
+		for (uint32_t i = 0; i < size(images); i++) handles[i] = images.first[i].first.get();
+		return ImageArray(std::move(handles), size(images));
+	}
+
+	// Logical Device for Graphics
+	class Device final
+	{
+		VkPhysicalDevice pDevRef;
+		UniqueObject<VkDevice> pInternal;
+		VkQueue devQueue, asyncQueue;
+		uint32_t queueFamilyIndex, computeFamilyIndex;
+		VkPhysicalDeviceMemoryProperties memProps;
+		VkPhysicalDeviceFeatures features;
+		const VkAllocationCallbacks* allocator;
+
+		Device(VkPhysicalDevice pd, VkDevice p, uint32_t qfi, uint32_t cfi, uint32_t computeQueueIndex,
+			const VkPhysicalDeviceFeatures& enabledFeatures, const VkAllocationCallbacks* alloc)
+			: pDevRef(pd), pInternal(p, &vkDestroyDevice, alloc), queueFamilyIndex(qfi), computeFamilyIndex(cfi), features(enabledFeatures), allocator(alloc)
+		{
+			vkGetDeviceQueue(p, queueFamilyIndex, 0, &devQueue);
+			vkGetDeviceQueue(p, computeFamilyIndex, computeQueueIndex, &asyncQueue);
+			vkGetPhysicalDeviceMemoryProperties(pd, &memProps);
+		}
+	public:
+		static auto create(VkPhysicalDevice pDev, RuntimeProfile profile, const VkAllocationCallbacks* allocator = nullptr, bool enableSwapchain = true)
+		{
+			VkDeviceCreateInfo devInfo{};
+			VkDeviceQueueCreateInfo queueInfo{};
+
+			// Search queue family index for Graphics Queue
+			uint32_t propertyCount, queueFamilyIndex = 0xffffffff;
+			vkGetPhysicalDeviceQueueFamilyProperties(pDev, &propertyCount, nullptr);
+			auto properties = std::make_unique<VkQueueFamilyProperties[]>(propertyCount);
+			vkGetPhysicalDeviceQueueFamilyProperties(pDev, &propertyCount, properties.get());
+			for (uint32_t i = 0; i < propertyCount; i++)
+			{
+				if ((properties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0)
+				{
+					queueFamilyIndex = i;
+					break;
+				}
+			}
+			if (queueFamilyIndex == 0xffffffff) throw std::runtime_error("No Graphics queues available on current device.");
+			// Async Compute: a compute-only family if there is one, else a second queue of the graphics family,
+			// else compute work shares the graphics queue
+			auto computeFamilyIndex = queueFamilyIndex;
+			uint32_t computeQueueIndex = properties[queueFamilyIndex].queueCount > 1 ? 1 : 0;
+			for (uint32_t i = 0; i < propertyCount; i++)
+			{
+				if ((properties[i].queueFlags & VK_QUEUE_COMPUTE_BIT) != 0 && (properties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) == 0)
+				{
+					computeFamilyIndex = i;
+					computeQueueIndex = 0;
+					break;
+				}
+			}
+
+			const char* layers[] = { "VK_LAYER_LUNARG_standard_validation" };
+			const char* extensions[] = { "VK_KHR_swapchain" };
+			static float qPriorities[] = { 0.0f, 0.0f };
+			VkDeviceQueueCreateInfo computeQueueInfo{};
+			queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			queueInfo.queueCount = computeFamilyIndex == queueFamilyIndex ? computeQueueIndex + 1 : 1;
+			queueInfo.queueFamilyIndex = queueFamilyIndex;
+			queueInfo.pQueuePriorities = qPriorities;
+			computeQueueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+			computeQueueInfo.queueCount = 1;
+			computeQueueInfo.queueFamilyIndex = computeFamilyIndex;
+			computeQueueInfo.pQueuePriorities = qPriorities;
+			const VkDeviceQueueCreateInfo queueInfos[] = { queueInfo, computeQueueInfo };
+			devInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+			devInfo.queueCreateInfoCount = computeFamilyIndex == queueFamilyIndex ? 1 : 2;
+			devInfo.pQueueCreateInfos = queueInfos;
+			devInfo.enabledLayerCount = describeProfile(profile).enableValidationLayers ? size(layers) : 0;
+			devInfo.ppEnabledLayerNames = layers;
+			devInfo.enabledExtensionCount = enableSwapchain ? size(extensions) : 0;
+			devInfo.ppEnabledExtensionNames = extensions;
+			// Block compressed textures are sampled directly when the device supports them
+			// Pipeline statistics queries are optional(PipelineStatistics turns itself off without them)
+			VkPhysicalDeviceFeatures supportedFeatures, enabledFeatures{};
+			vkGetPhysicalDeviceFeatures(pDev, &supportedFeatures);
+			enabledFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+			enabledFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+			devInfo.pEnabledFeatures = &enabledFeatures;
+
+			VkDevice device;
+			auto res = vkCreateDevice(pDev, &devInfo, allocator, &device);
+			checkError(res);
+			return Device(pDev, device, queueFamilyIndex, computeFamilyIndex, computeQueueIndex, enabledFeatures, allocator);
+		}
+
+		auto handle() const noexcept { return this->pInternal.get(); }
+		auto physicalDevice() const noexcept { return this->pDevRef; }
+		const auto& enabledFeatures() const noexcept { return this->features; }
+		auto queueFamily() const noexcept { return this->queueFamilyIndex; }
+		auto computeQueueFamily() const noexcept { return this->computeFamilyIndex; }
+		auto graphicsQueue() const noexcept { return this->devQueue; }
+		auto computeQueue() const noexcept { return this->asyncQueue; }
+		// false when compute work is submitted to the graphics queue itself
+		auto hasAsyncCompute() const noexcept { return this->asyncQueue != this->devQueue; }
+		auto formatProperties(VkFormat format) const
+		{
+			VkFormatProperties props;
+			vkGetPhysicalDeviceFormatProperties(this->pDevRef, format, &props);
+			return props;
+		}
+
+		// Derived from this
+		auto createCommandPool() { return this->createCommandPool(this->queueFamilyIndex); }
+		CommandPool createCommandPool(uint32_t queueFamily)
+		{
+			VkCommandPoolCreateInfo info{};
+
+			info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+			info.queueFamilyIndex = queueFamily;
+			info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+			VkCommandPool object;
+			auto res = vkCreateCommandPool(this->pInternal.get(), &info, this->allocator, &object);
+			checkError(res);
+			return CommandPool(this->pInternal.get(), object, &vkDestroyCommandPool, this->allocator);
+		}
+		// Usage of the swapchain images created for the surface(transfer destination only when the surface supports it)
+		auto swapchainUsage(const Surface& surface)
+		{
+			VkSurfaceCapabilitiesKHR surfaceCaps;
+			vkGetPhysicalDeviceSurfaceCapabilitiesKHR(this->pDevRef, surface.get(), &surfaceCaps);
+			return static_cast<VkImageUsageFlags>(VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | (surfaceCaps.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT));
+		}
+		auto createSwapchain(const Surface& surface)
+		{
+			VkSwapchainCreateInfoKHR scinfo{};
+
+			VkBool32 surfaceSupported;
+			vkGetPhysicalDeviceSurfaceSupportKHR(this->pDevRef, this->queueFamilyIndex, surface.get(), &surfaceSupported);
+			VkSurfaceCapabilitiesKHR surfaceCaps;
+			vkGetPhysicalDeviceSurfaceCapabilitiesKHR(this->pDevRef, surface.get(), &surfaceCaps);
+			uint32_t surfaceFormatCount;
+			vkGetPhysicalDeviceSurfaceFormatsKHR(this->pDevRef, surface.get(), &surfaceFormatCount, nullptr);
+			auto surfaceFormats = std::make_unique<VkSurfaceFormatKHR[]>(surfaceFormatCount);
+			vkGetPhysicalDeviceSurfaceFormatsKHR(this->pDevRef, surface.get(), &surfaceFormatCount, surfaceFormats.get());
+			uint32_t presentModeCount;
+			vkGetPhysicalDeviceSurfacePresentModesKHR(this->pDevRef, surface.get(), &presentModeCount, nullptr);
+			auto presentModes = std::make_unique<VkPresentModeKHR[]>(presentModeCount);
+			vkGetPhysicalDeviceSurfacePresentModesKHR(this->pDevRef, surface.get(), &presentModeCount, presentModes.get());
+
+			for (uint32_t i = 0; i < surfaceFormatCount; i++)
+			{
+				auto c = surfaceFormats[i];
+				OutputDebugString(L"Supported Format Check...");
+			}
+
+			scinfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+			scinfo.surface = surface.get();
+			scinfo.minImageCount = 2;
+			scinfo.imageFormat = VK_FORMAT_B8G8R8A8_UNORM;
+			scinfo.imageColorSpace = VK_COLORSPACE_SRGB_NONLINEAR_KHR;
+			scinfo.imageExtent.width = 640;
+			scinfo.imageExtent.height = 480;
+			scinfo.imageArrayLayers = 1;
+			// Transfer destination when supported(upscaled by a blit with dynamic resolution)
+			scinfo.imageUsage = this->swapchainUsage(surface);
+			scinfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			scinfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+			scinfo.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+			scinfo.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+			scinfo.clipped = VK_TRUE;
+
+			VkSwapchainKHR object;
+			auto res = vkCreateSwapchainKHR(this->pInternal.get(), &scinfo, this->allocator, &object);
+			checkError(res);
+			return Swapchain(this->pInternal.get(), object, &vkDestroySwapchainKHR, this->allocator);
+		}
+		auto retrieveImagesFromSwapchain(const Swapchain& chain)
+		{
+			uint32_t imageCount;
+			auto res = vkGetSwapchainImagesKHR(this->pInternal.get(), chain.get(), &imageCount, nullptr);
+			checkError(res);
+			auto images = std::make_unique<VkImage[]>(imageCount);
+			res = vkGetSwapchainImagesKHR(this->pInternal.get(), chain.get(), &imageCount, images.get());
+			checkError(res);
+			return ImageArray(std::move(images), imageCount);
+		}
+		auto createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+			uint32_t baseMipLevel = 0, uint32_t levelCount = 1)
+		{
+			VkImageViewCreateInfo vinfo{};
+			vinfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+			vinfo.image = image;
+			vinfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+			vinfo.format = format;
+			vinfo.components = {
+				VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_G, VK_COMPONENT_SWIZZLE_B, VK_COMPONENT_SWIZZLE_A
+			};
+			vinfo.subresourceRange = { aspect, baseMipLevel, levelCount, 0, 1 };
+
+			VkImageView view;
+			auto res = vkCreateImageView(this->pInternal.get(), &vinfo, this->allocator, &view);
+			checkError(res);
+			return ImageView(this->pInternal.get(), view, &vkDestroyImageView, this->allocator);
+		}
+		auto createImageViews(const ImageArray& images)
+		{
+			auto views = std::make_unique<ImageView[]>(size(images));
+
+			for (uint32_t i = 0; i < size(images); i++)
+			{
+				views[i] = this->createImageView(images.first[i], VK_FORMAT_B8G8R8A8_UNORM);
+			}
+			return ImageViewArray(std::move(views), size(images));
+		}
+		auto createRenderPass(const RenderPassBuilder& builder)
+		{
+			std::vector<std::vector<uint32_t>> preserveStorage;
+			const auto attachments = builder.describeAttachments();
+			const auto subpasses = builder.describeSubpasses(preserveStorage);
+			const auto dependencies = builder.describeDependencies();
+
+			VkRenderPassCreateInfo renderPassInfo{};
+			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+			renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+			renderPassInfo.pAttachments = attachments.data();
+			renderPassInfo.subpassCount = static_cast<uint32_t>(subpasses.size());
+			renderPassInfo.pSubpasses = subpasses.data();
+			renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+			renderPassInfo.pDependencies = dependencies.empty() ? nullptr : dependencies.data();
+
+			VkRenderPass object;
+			auto res = vkCreateRenderPass(this->pInternal.get(), &renderPassInfo, this->allocator, &object);
+			checkError(res);
+			return RenderPass(this->pInternal.get(), object, &vkDestroyRenderPass, this->allocator);
+		}
+		// Single subpass, single color attachment
+		// finalLayout: PRESENT_SRC_KHR for swapchain images, TRANSFER_SRC_OPTIMAL for offscreen(headless) targets
+		static auto describeCommonRenderPass(VkImageLayout finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
+		{
+			RenderPassBuilder builder;
+			const auto target = builder.addExternalColor(VK_FORMAT_B8G8R8A8_UNORM, finalLayout);
+			builder.subpass().color(target);
+			return builder;
+		}
+		auto createCommonRenderPass(VkImageLayout finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
+		{
+			return this->createRenderPass(describeCommonRenderPass(finalLayout));
+		}
+		auto createFramebuffers(const RenderPass& renderPass, const ImageViewArray& imageViews)
+		{
+			auto buffers = std::make_unique<Framebuffer[]>(size(imageViews));
+
+			// Common Properties
+			VkFramebufferCreateInfo fbinfo{};
+			VkImageView attachmentViews[1];
+
+			fbinfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			fbinfo.attachmentCount = 1;
+			fbinfo.renderPass = renderPass.get();
+			fbinfo.pAttachments = attachmentViews;
+			fbinfo.width = 640;
+			fbinfo.height = 480;
+			fbinfo.layers = 1;
+
+			for (uint32_t i = 0; i < size(imageViews); i++)
+			{
+				attachmentViews[0] = imageViews.first[i].get();
+
+				VkFramebuffer fb;
+				auto res = vkCreateFramebuffer(this->pInternal.get(), &fbinfo, this->allocator, &fb);
+				checkError(res);
+				buffers[i] = Framebuffer(this->pInternal.get(), fb, &vkDestroyFramebuffer, this->allocator);
+			}
+			return FramebufferArray(std::move(buffers), size(imageViews));
+		}
+		// One framebuffer per external image view; transient attachments are created once and shared
+		auto createFramebuffers(const RenderPass& renderPass, const RenderPassBuilder& builder, const ImageViewArray& externalViews,
+			VkExtent2D extent = VkExtent2D{ 640, 480 })
+		{
+			FramebufferSet set{ FramebufferArray(std::make_unique<Framebuffer[]>(size(externalViews)), size(externalViews)), {}, {}, 0 };
+			std::vector<VkImageView> attachmentViews(builder.attachmentCount(), VK_NULL_HANDLE);
+			uint32_t externalIndex = UINT32_MAX;
+
+			for (uint32_t i = 0; i < builder.attachmentCount(); i++)
+			{
+				if (!builder.isTransient(i))
+				{
+					if (externalIndex != UINT32_MAX) throw std::logic_error("Only one external attachment is supported per framebuffer");
+					externalIndex = i;
+					continue;
+				}
+				const auto& a = builder.attachment(i);
+				bool lazy;
+				set.transientImages.push_back(this->createTransientImage(extent, a.format, a.samples, builder.transientUsage(i), &lazy));
+				set.transientViews.push_back(this->createImageView(set.transientImages.back().first.get(), a.format, builder.aspect(i)));
+				attachmentViews[i] = set.transientViews.back().get();
+				if (lazy) set.lazilyAllocatedCount++;
+			}
+
+			VkFramebufferCreateInfo fbinfo{};
+			fbinfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			fbinfo.attachmentCount = static_cast<uint32_t>(attachmentViews.size());
+			fbinfo.renderPass = renderPass.get();
+			fbinfo.pAttachments = attachmentViews.data();
+			fbinfo.width = extent.width;
+			fbinfo.height = extent.height;
+			fbinfo.layers = 1;
+
+			for (uint32_t i = 0; i < size(externalViews); i++)
+			{
+				if (externalIndex != UINT32_MAX) attachmentViews[externalIndex] = externalViews.first[i].get();
+
+				VkFramebuffer fb;
+				auto res = vkCreateFramebuffer(this->pInternal.get(), &fbinfo, this->allocator, &fb);
+				checkError(res);
+				set.framebuffers.first[i] = Framebuffer(this->pInternal.get(), fb, &vkDestroyFramebuffer, this->allocator);
+			}
+			return set;
+		}
+		// Highest sample count not above requested that color and depth framebuffers support
+		VkSampleCountFlagBits supportedSampleCount(VkSampleCountFlagBits requested) const
+		{
+			VkPhysicalDeviceProperties props;
+			vkGetPhysicalDeviceProperties(this->pDevRef, &props);
+			const auto supported = props.limits.framebufferColorSampleCounts & props.limits.framebufferDepthSampleCounts;
+			auto count = static_cast<uint32_t>(requested);
+			while (count > 1 && (supported & count) == 0) count >>= 1;
+			return static_cast<VkSampleCountFlagBits>(count);
+		}
+
+		// Memory type satisfying both resource requirement and property flags(UINT32_MAX if none)
+		uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags flags) const
+		{
+			for (uint32_t i = 0; i < this->memProps.memoryTypeCount; i++)
+			{
+				if ((typeBits & (1u << i)) != 0 && (this->memProps.memoryTypes[i].propertyFlags & flags) == flags) return i;
+			}
+			return UINT32_MAX;
+		}
+
+		// Image Resources
+		// Allocates and binds memory of the preferred type, falling back to requiredFlags-only types
+		auto allocateImageMemory(VkImage image, VkMemoryPropertyFlags preferredFlags, VkMemoryPropertyFlags requiredFlags, bool* usedPreferred = nullptr)
+		{
+			VkMemoryRequirements memreq;
+			VkMemoryAllocateInfo allocInfo{};
+			vkGetImageMemoryRequirements(this->pInternal.get(), image, &memreq);
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = memreq.size;
+			allocInfo.memoryTypeIndex = this->findMemoryType(memreq.memoryTypeBits, preferredFlags);
+			if (usedPreferred != nullptr) *usedPreferred = allocInfo.memoryTypeIndex != UINT32_MAX;
+			if (allocInfo.memoryTypeIndex == UINT32_MAX) allocInfo.memoryTypeIndex = this->findMemoryType(memreq.memoryTypeBits, requiredFlags);
+			if (allocInfo.memoryTypeIndex == UINT32_MAX) throw std::runtime_error("No found available heap.");
+
+			VkDeviceMemory mem;
+			auto res = vkAllocateMemory(this->pInternal.get(), &allocInfo, this->allocator, &mem);
+			checkError(res);
+			auto memoryObject = DeviceMemory(this->pInternal.get(), mem, &vkFreeMemory, this->allocator);
+			res = vkBindImageMemory(this->pInternal.get(), image, mem, 0);
+			checkError(res);
+			return memoryObject;
+		}
+		// shareWithCompute: accessed from both graphics and compute queue families without ownership transfers
+		auto createImageObject(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage, VkSampleCountFlagBits samples, uint32_t mipLevels = 1,
+			bool shareWithCompute = false)
+		{
+			const uint32_t families[] = { this->queueFamilyIndex, this->computeFamilyIndex };
+			VkImageCreateInfo imageInfo{};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.format = format;
+			imageInfo.extent = { extent.width, extent.height, 1 };
+			imageInfo.mipLevels = mipLevels;
+			imageInfo.arrayLayers = 1;
+			imageInfo.samples = samples;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.usage = usage;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			if (shareWithCompute && this->computeFamilyIndex != this->queueFamilyIndex)
+			{
+				imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+				imageInfo.queueFamilyIndexCount = 2;
+				imageInfo.pQueueFamilyIndices = families;
+			}
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			VkImage image;
+			auto res = vkCreateImage(this->pInternal.get(), &imageInfo, this->allocator, &image);
+			checkError(res);
+			return Image(this->pInternal.get(), image, &vkDestroyImage, this->allocator);
+		}
+		auto createImage(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage,
+			VkMemoryPropertyFlags memoryFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT)
+		{
+			auto imageObject = this->createImageObject(extent, format, usage, samples);
+			auto memoryObject = this->allocateImageMemory(imageObject.get(), memoryFlags, memoryFlags);
+			return ImageData(std::move(imageObject), std::move(memoryObject));
+		}
+		// Attachment image whose contents never leave the render pass.
+		// Backed by lazily allocated memory when the device has it(tile memory on tiled GPUs), device local otherwise.
+		ImageData createTransientImage(VkExtent2D extent, VkFormat format, VkSampleCountFlagBits samples, VkImageUsageFlags usage, bool* lazilyAllocated = nullptr)
+		{
+			auto imageObject = this->createImageObject(extent, format, usage | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, samples);
+			auto memoryObject = this->allocateImageMemory(imageObject.get(),
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, lazilyAllocated);
+			return ImageData(std::move(imageObject), std::move(memoryObject));
+		}
+		// Device local image used by both graphics and compute queues
+		auto createSharedImage(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage)
+		{
+			auto imageObject = this->createImageObject(extent, format, usage, VK_SAMPLE_COUNT_1_BIT, 1, true);
+			auto memoryObject = this->allocateImageMemory(imageObject.get(), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			return ImageData(std::move(imageObject), std::move(memoryObject));
+		}
+		// Color render targets sampled by compute work(post-processing input)
+		auto createSharedRenderTargetImages(uint32_t count, VkExtent2D extent, VkFormat format)
+		{
+			auto images = std::make_unique<ImageData[]>(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				images[i] = this->createSharedImage(extent, format,
+					VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+			}
+			return ImageDataArray(std::move(images), count);
+		}
+		// Color render targets used instead of swapchain images in headless mode
+		auto createRenderTargetImages(uint32_t count, VkExtent2D extent, VkFormat format)
+		{
+			auto images = std::make_unique<ImageData[]>(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				images[i] = this->createImage(extent, format,
+					VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+			}
+			return ImageDataArray(std::move(images), count);
+		}
+
+		// Buffer Resources
+		auto createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryFlags)
+		{
+			VkBufferCreateInfo bufferInfo{};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.usage = usage;
+			bufferInfo.size = size;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			VkBuffer buffer;
+			auto res = vkCreateBuffer(this->pInternal.get(), &bufferInfo, this->allocator, &buffer);
+			checkError(res);
+			auto bufferObject = Buffer(this->pInternal.get(), buffer, &vkDestroyBuffer, this->allocator);
+
+			VkMemoryRequirements memreq;
+			VkMemoryAllocateInfo allocInfo{};
+			vkGetBufferMemoryRequirements(this->pInternal.get(), buffer, &memreq);
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = memreq.size;
+			allocInfo.memoryTypeIndex = this->findMemoryType(memreq.memoryTypeBits, memoryFlags);
+			if (allocInfo.memoryTypeIndex == UINT32_MAX) throw std::runtime_error("No found available heap.");
+
+			VkDeviceMemory mem;
+			res = vkAllocateMemory(this->pInternal.get(), &allocInfo, this->allocator, &mem);
+			checkError(res);
+			auto memoryObject = DeviceMemory(this->pInternal.get(), mem, &vkFreeMemory, this->allocator);
+			res = vkBindBufferMemory(this->pInternal.get(), buffer, mem, 0);
+			checkError(res);
+			return BufferData(std::move(bufferObject), std::move(memoryObject));
+		}
+		template<typename VertexT, size_t nElements>
+		auto createVertexBuffer(const VertexT(&data)[nElements])
+		{
+			VkBufferCreateInfo bufferInfo{};
+			bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+			bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+			bufferInfo.size = sizeof(VertexT) * nElements;
+			bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+			VkBuffer buffer;
+			auto res = vkCreateBuffer(this->pInternal.get(), &bufferInfo, this->allocator, &buffer);
+			checkError(res);
+
+			// Memory Allocation
+			VkMemoryRequirements memreq;
+			VkMemoryAllocateInfo allocInfo{};
+			vkGetBufferMemoryRequirements(this->pInternal.get(), buffer, &memreq);
+			allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			allocInfo.allocationSize = memreq.size;
+			// Search memory index can be visible from host
+			allocInfo.memoryTypeIndex = this->findMemoryType(memreq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+			if (allocInfo.memoryTypeIndex == UINT32_MAX) throw std::runtime_error("No found available heap.");
+
+			VkDeviceMemory mem;
+			res = vkAllocateMemory(this->pInternal.get(), &allocInfo, this->allocator, &mem);
+			checkError(res);
+
+			// Set data
+			uint8_t* pData;
+			res = vkMapMemory(this->pInternal.get(), mem, 0, sizeof(VertexT) * nElements, 0, reinterpret_cast<void**>(&pData));
+			checkError(res);
+			memcpy(pData, data, sizeof(VertexT) * nElements);
+			vkUnmapMemory(this->pInternal.get(), mem);
+
+			// Associate memory to buffer
+			res = vkBindBufferMemory(this->pInternal.get(), buffer, mem, 0);
+			checkError(res);
+
+			return BufferData(Buffer(this->pInternal.get(), buffer, &vkDestroyBuffer, this->allocator), DeviceMemory(this->pInternal.get(), mem, &vkFreeMemory, this->allocator));
+		}
+		auto createShaderModule(const std::wstring& path)
+		{
+			const auto bin = BinaryLoader::load(path);
+			return this->createShaderModule(bin.first.get(), bin.second);
+		}
+		// SPIR-V bytecode already in memory(codeSize in bytes)
+		ShaderModule createShaderModule(const void* code, size_t codeSize)
+		{
+			VkShaderModuleCreateInfo shaderInfo{};
+
+			shaderInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+			shaderInfo.codeSize = codeSize;
+			shaderInfo.pCode = reinterpret_cast<const uint32_t*>(code);
+
+			VkShaderModule mod;
+			auto res = vkCreateShaderModule(this->pInternal.get(), &shaderInfo, this->allocator, &mod);
+			checkError(res);
+			return ShaderModule(this->pInternal.get(), mod, &vkDestroyShaderModule, this->allocator);
+		}
+		auto createPipelineLayout()
+		{
+			VkPipelineLayoutCreateInfo pLayoutInfo{};
+
+			pLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+
+			VkPipelineLayout pLayout;
+			auto res = vkCreatePipelineLayout(this->pInternal.get(), &pLayoutInfo, this->allocator, &pLayout);
+			checkError(res);
+			return PipelineLayout(this->pInternal.get(), pLayout, &vkDestroyPipelineLayout, this->allocator);
+		}
+		PipelineLayout createPipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstants)
+		{
+			VkPipelineLayoutCreateInfo pLayoutInfo{};
+
+			pLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			pLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+			pLayoutInfo.pSetLayouts = setLayouts.data();
+			pLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstants.size());
+			pLayoutInfo.pPushConstantRanges = pushConstants.data();
+
+			VkPipelineLayout pLayout;
+			auto res = vkCreatePipelineLayout(this->pInternal.get(), &pLayoutInfo, this->allocator, &pLayout);
+			checkError(res);
+			return PipelineLayout(this->pInternal.get(), pLayout, &vkDestroyPipelineLayout, this->allocator);
+		}
+
+		// Descriptor Resources
+		auto createDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+		{
+			VkDescriptorSetLayoutCreateInfo layoutInfo{};
+
+			layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+			layoutInfo.pBindings = bindings.data();
+
+			VkDescriptorSetLayout layout;
+			auto res = vkCreateDescriptorSetLayout(this->pInternal.get(), &layoutInfo, this->allocator, &layout);
+			checkError(res);
+			return DescriptorSetLayout(this->pInternal.get(), layout, &vkDestroyDescriptorSetLayout, this->allocator);
+		}
+		auto createDescriptorPool(uint32_t maxSets, const std::vector<VkDescriptorPoolSize>& poolSizes)
+		{
+			VkDescriptorPoolCreateInfo poolInfo{};
+
+			poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+			poolInfo.maxSets = maxSets;
+			poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+			poolInfo.pPoolSizes = poolSizes.data();
+
+			VkDescriptorPool pool;
+			auto res = vkCreateDescriptorPool(this->pInternal.get(), &poolInfo, this->allocator, &pool);
+			checkError(res);
+			return DescriptorPool(this->pInternal.get(), pool, &vkDestroyDescriptorPool, this->allocator);
+		}
+		// Sets are released together with their pool
+		auto allocateDescriptorSet(const DescriptorPool& pool, const DescriptorSetLayout& layout)
+		{
+			VkDescriptorSetAllocateInfo allocInfo{};
+
+			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocInfo.descriptorPool = pool.get();
+			allocInfo.descriptorSetCount = 1;
+			allocInfo.pSetLayouts = &layout.get();
+
+			VkDescriptorSet set;
+			auto res = vkAllocateDescriptorSets(this->pInternal.get(), &allocInfo, &set);
+			checkError(res);
+			return set;
+		}
+		// type: SAMPLED_IMAGE/COMBINED_IMAGE_SAMPLER(sampler may be VK_NULL_HANDLE for the former) or STORAGE_IMAGE
+		void updateImageDescriptor(VkDescriptorSet set, uint32_t binding, VkDescriptorType type, VkSampler sampler, VkImageView view, VkImageLayout layout)
+		{
+			const VkDescriptorImageInfo imageInfo{ sampler, view, layout };
+			VkWriteDescriptorSet write{};
+
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = set;
+			write.dstBinding = binding;
+			write.descriptorCount = 1;
+			write.descriptorType = type;
+			write.pImageInfo = &imageInfo;
+			vkUpdateDescriptorSets(this->pInternal.get(), 1, &write, 0, nullptr);
+		}
+		// Points storage buffer bindings[0..n) of set at whole buffers
+		void updateStorageBuffers(VkDescriptorSet set, const std::vector<VkBuffer>& buffers)
+		{
+			std::vector<VkDescriptorBufferInfo> bufferInfos;
+			std::vector<VkWriteDescriptorSet> writes(buffers.size());
+			for (const auto b : buffers) bufferInfos.push_back(VkDescriptorBufferInfo{ b, 0, VK_WHOLE_SIZE });
+			for (uint32_t i = 0; i < buffers.size(); i++)
+			{
+				writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				writes[i].dstSet = set;
+				writes[i].dstBinding = i;
+				writes[i].descriptorCount = 1;
+				writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				writes[i].pBufferInfo = &bufferInfos[i];
+			}
+			vkUpdateDescriptorSets(this->pInternal.get(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+		}
+		auto createSampler(const VkSamplerCreateInfo& info)
+		{
+			VkSampler sampler;
+			auto res = vkCreateSampler(this->pInternal.get(), &info, this->allocator, &sampler);
+			checkError(res);
+			return Sampler(this->pInternal.get(), sampler, &vkDestroySampler, this->allocator);
+		}
+		auto createPipelineCache()
+		{
+			VkPipelineCacheCreateInfo cacheInfo{};
+
+			cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+			VkPipelineCache cache;
+			auto res = vkCreatePipelineCache(this->pInternal.get(), &cacheInfo, this->allocator, &cache);
+			checkError(res);
+			return PipelineCache(this->pInternal.get(), cache, &vkDestroyPipelineCache, this->allocator);
+		}
+		auto createGraphicsPipeline(const GraphicsPipelineDesc& desc, const PipelineCache& pCache)
+		{
+			const auto& state = desc.state;
+			const auto vshaderSpec = desc.vertexSpec.info();
+			const auto fshaderSpec = desc.fragmentSpec.info();
+			VkPipelineShaderStageCreateInfo stageInfo[2]{};
+			VkPipelineVertexInputStateCreateInfo vinStateInfo{};
+			VkPipelineInputAssemblyStateCreateInfo iaInfo{};
+			VkPipelineViewportStateCreateInfo vpInfo{};
+			VkPipelineRasterizationStateCreateInfo rasterizerStateInfo{};
+			VkPipelineMultisampleStateCreateInfo msInfo{};
+			VkPipelineDepthStencilStateCreateInfo dsInfo{};
+			VkPipelineColorBlendAttachmentState blendState{};
+			VkPipelineColorBlendStateCreateInfo blendInfo{};
+			VkPipelineDynamicStateCreateInfo dynamicInfo{};
+			VkGraphicsPipelineCreateInfo gpInfo{};
+
+			// Viewport and Scissor are supplied by vkCmdSetViewport/vkCmdSetScissor
+			static VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+			stageInfo[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			stageInfo[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			stageInfo[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+			stageInfo[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+			stageInfo[0].module = desc.vertexShader;
+			stageInfo[1].module = desc.fragmentShader;
+			stageInfo[0].pName = "main";
+			stageInfo[1].pName = "main";
+			stageInfo[0].pSpecializationInfo = desc.vertexSpec.empty() ? nullptr : &vshaderSpec;
+			stageInfo[1].pSpecializationInfo = desc.fragmentSpec.empty() ? nullptr : &fshaderSpec;
+			vinStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+			vinStateInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(desc.vertexBindings.size());
+			vinStateInfo.pVertexBindingDescriptions = desc.vertexBindings.data();
+			vinStateInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(desc.vertexAttributes.size());
+			vinStateInfo.pVertexAttributeDescriptions = desc.vertexAttributes.data();
+			iaInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+			vpInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+			vpInfo.viewportCount = 1;
+			vpInfo.scissorCount = 1;
+			rasterizerStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+			rasterizerStateInfo.depthClampEnable = VK_FALSE;
+			rasterizerStateInfo.rasterizerDiscardEnable = VK_FALSE;
+			rasterizerStateInfo.depthBiasEnable = VK_FALSE;
+			rasterizerStateInfo.lineWidth = 1.0f;
+			msInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+			msInfo.sampleShadingEnable = VK_FALSE;
+			msInfo.alphaToCoverageEnable = VK_FALSE;
+			msInfo.alphaToOneEnable = VK_FALSE;
+			dsInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+			dsInfo.maxDepthBounds = 1.0f;
+			blendState.colorWriteMask = VK_COLOR_COMPONENT_A_BIT
+				| VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_R_BIT;
+			state.apply(iaInfo, rasterizerStateInfo, msInfo, dsInfo, blendState);
+			blendInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+			blendInfo.logicOpEnable = VK_FALSE;
+			blendInfo.attachmentCount = 1;
+			blendInfo.pAttachments = &blendState;
+			dynamicInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+			dynamicInfo.dynamicStateCount = size(dynamicStates);
+			dynamicInfo.pDynamicStates = dynamicStates;
+			gpInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+			gpInfo.stageCount = size(stageInfo);
+			gpInfo.pStages = stageInfo;
+			gpInfo.pVertexInputState = &vinStateInfo;
+			gpInfo.pInputAssemblyState = &iaInfo;
+			gpInfo.pViewportState = &vpInfo;
+			gpInfo.pRasterizationState = &rasterizerStateInfo;
+			gpInfo.pMultisampleState = &msInfo;
+			// Required whenever the subpass has a depth attachment; test/write are simply disabled when unused
+			gpInfo.pDepthStencilState = &dsInfo;
+			gpInfo.pColorBlendState = &blendInfo;
+			gpInfo.pDynamicState = &dynamicInfo;
+			gpInfo.layout = desc.layout;
+			gpInfo.renderPass = desc.renderPass;
+			gpInfo.subpass = desc.subpass;
+
+			VkPipeline pl;
+			auto res = vkCreateGraphicsPipelines(this->pInternal.get(), pCache.get(), 1, &gpInfo, this->allocator, &pl);
+			checkError(res);
+			return Pipeline(this->pInternal.get(), pl, &vkDestroyPipeline, this->allocator);
+		}
+		auto createComputePipeline(const ShaderModule& shader, const PipelineLayout& layout, const PipelineCache& pCache,
+			const VkSpecializationInfo* spec = nullptr)
+		{
+			VkComputePipelineCreateInfo cpInfo{};
+
+			cpInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+			cpInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+			cpInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+			cpInfo.stage.module = shader.get();
+			cpInfo.stage.pName = "main";
+			cpInfo.stage.pSpecializationInfo = spec;
+			cpInfo.layout = layout.get();
+
+			VkPipeline pl;
+			auto res = vkCreateComputePipelines(this->pInternal.get(), pCache.get(), 1, &cpInfo, this->allocator, &pl);
+			checkError(res);
+			return Pipeline(this->pInternal.get(), pl, &vkDestroyPipeline, this->allocator);
+		}
+		template<size_t nAttrElements>
+		static auto describeGraphicsPipelineVF(
+			const ShaderModule& vshader, const ShaderModule& fshader,
+			const VkVertexInputBindingDescription& bindDesc, const VkVertexInputAttributeDescription(&attrDescs)[nAttrElements],
+			const PipelineLayout& pLayout, const RenderPass& renderPass,
+			PipelineStateKey state = PipelineVariant<>::key(),
+			const VkSpecializationInfo* vshaderSpec = nullptr, const VkSpecializationInfo* fshaderSpec = nullptr)
+		{
+			GraphicsPipelineDesc desc;
+
+			desc.vertexShader = vshader.get();
+			desc.fragmentShader = fshader.get();
+			desc.vertexSpec = SpecializationData::from(vshaderSpec);
+			desc.fragmentSpec = SpecializationData::from(fshaderSpec);
+			desc.vertexBindings.assign(&bindDesc, &bindDesc + 1);
+			desc.vertexAttributes.assign(attrDescs, attrDescs + nAttrElements);
+			desc.state = state;
+			desc.layout = pLayout.get();
+			desc.renderPass = renderPass.get();
+			desc.subpass = 0;
+			return desc;
+		}
+		template<size_t nAttrElements>
+		auto createGraphicsPipelineVF(
+			const ShaderModule& vshader, const ShaderModule& fshader,
+			const VkVertexInputBindingDescription& bindDesc, const VkVertexInputAttributeDescription(&attrDescs)[nAttrElements],
+			const PipelineLayout& pLayout, const RenderPass& renderPass, const PipelineCache& pCache,
+			PipelineStateKey state = PipelineVariant<>::key(),
+			const VkSpecializationInfo* vshaderSpec = nullptr, const VkSpecializationInfo* fshaderSpec = nullptr)
+		{
+			return this->createGraphicsPipeline(describeGraphicsPipelineVF(vshader, fshader, bindDesc, attrDescs, pLayout, renderPass,
+				state, vshaderSpec, fshaderSpec), pCache);
+		}
+		// Pipeline variant fixed at compile time: state from VariantT, shader constants from StaticSpecialization
+		// (only the sample count of the render pass is given at runtime)
+		template<typename VariantT, typename VertexSpecT = StaticSpecialization<>, typename FragmentSpecT = StaticSpecialization<>, size_t nAttrElements>
+		static auto describeGraphicsPipelineVariant(
+			const ShaderModule& vshader, const ShaderModule& fshader,
+			const VkVertexInputBindingDescription& bindDesc, const VkVertexInputAttributeDescription(&attrDescs)[nAttrElements],
+			const PipelineLayout& pLayout, const RenderPass& renderPass, VkSampleCountFlags samples = VK_SAMPLE_COUNT_1_BIT)
+		{
+			return describeGraphicsPipelineVF(vshader, fshader, bindDesc, attrDescs, pLayout, renderPass,
+				VariantT::key(samples), VertexSpecT::info(), FragmentSpecT::info());
+		}
+		auto createCommandBuffers(const CommandPool& pool, uint32_t nBuffers)
+		{
+			VkCommandBufferAllocateInfo cbAllocInfo{};
+
+			cbAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			cbAllocInfo.commandPool = pool.get();
+			cbAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			cbAllocInfo.commandBufferCount = nBuffers;
+
+			auto buffers = CommandBuffers(this->pInternal.get(), pool.get(), nBuffers);
+			auto res = vkAllocateCommandBuffers(this->pInternal.get(), &cbAllocInfo, buffers.data());
+			checkError(res);
+			return buffers;
+		}
+		auto createQueryPool(VkQueryType type, uint32_t count, VkQueryPipelineStatisticFlags pipelineStatistics = 0)
+		{
+			VkQueryPoolCreateInfo qinfo{};
+
+			qinfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			qinfo.queryType = type;
+			qinfo.queryCount = count;
+			qinfo.pipelineStatistics = pipelineStatistics;
+
+			VkQueryPool pool;
+			auto res = vkCreateQueryPool(this->pInternal.get(), &qinfo, this->allocator, &pool);
+			checkError(res);
+			return QueryPool(this->pInternal.get(), pool, &vkDestroyQueryPool, this->allocator);
+		}
+		auto createFence()
+		{
+			VkFenceCreateInfo finfo{};
+
+			finfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+			VkFence fence;
+			auto res = vkCreateFence(this->pInternal.get(), &finfo, this->allocator, &fence);
+			checkError(res);
+			return Fence(this->pInternal.get(), fence, &vkDestroyFence, this->allocator);
+		}
+		auto createSemaphore()
+		{
+			VkSemaphoreCreateInfo sinfo{};
+
+			sinfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+			VkSemaphore semaphore;
+			auto res = vkCreateSemaphore(this->pInternal.get(), &sinfo, this->allocator, &semaphore);
+			checkError(res);
+			return Semaphore(this->pInternal.get(), semaphore, &vkDestroySemaphore, this->allocator);
+		}
+
+		// Command Shortcuts //
+		void submitCommandAndWait(VkCommandBuffer buffer)
+		{
+			static VkPipelineStageFlags stageFlags = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+			VkSubmitInfo sinfo{};
+
+			sinfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			sinfo.pWaitDstStageMask = &stageFlags;
+			sinfo.commandBufferCount = 1;
+			sinfo.pCommandBuffers = &buffer;
+
+			auto res = vkQueueSubmit(this->devQueue, 1, &sinfo, VK_NULL_HANDLE);
+			checkError(res);
+			res = vkQueueWaitIdle(this->devQueue);
+			checkError(res);
+		}
+		void acquireNextImageAndWait(const Swapchain& swapchain, const Fence& fence, uint32_t& nextFrameIndex)
+		{
+			auto res = vkAcquireNextImageKHR(this->pInternal.get(), swapchain.get(),
+				UINT64_MAX, VK_NULL_HANDLE, fence.get(), &nextFrameIndex);
+			Vulkan::checkError(res);
+			res = vkWaitForFences(this->pInternal.get(), 1, &fence.get(), VK_FALSE, UINT64_MAX);
+			Vulkan::checkError(res);
+			res = vkResetFences(this->pInternal.get(), 1, &fence.get());
+			Vulkan::checkError(res);
+		}
+		void submitCommands(VkCommandBuffer buffer, const Fence& fence)
+		{
+			VkSubmitInfo sinfo{};
+			static const VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+			sinfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			sinfo.commandBufferCount = 1;
+			sinfo.pCommandBuffers = &buffer;
+			sinfo.pWaitDstStageMask = &waitStageMask;
+			auto res = vkQueueSubmit(devQueue, 1, &sinfo, fence.get());
+			checkError(res);
+		}
+		// Submission to any queue of this device(all waits happen at waitStage)
+		void submitCommands(VkQueue queue, VkCommandBuffer buffer, const std::vector<VkSemaphore>& waitSemaphores, VkPipelineStageFlags waitStage,
+			const std::vector<VkSemaphore>& signalSemaphores, const Fence& fence)
+		{
+			const std::vector<VkPipelineStageFlags> waitStages(waitSemaphores.size(), waitStage);
+			VkSubmitInfo sinfo{};
+
+			sinfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			sinfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+			sinfo.pWaitSemaphores = waitSemaphores.data();
+			sinfo.pWaitDstStageMask = waitStages.data();
+			sinfo.commandBufferCount = 1;
+			sinfo.pCommandBuffers = &buffer;
+			sinfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+			sinfo.pSignalSemaphores = signalSemaphores.data();
+			auto res = vkQueueSubmit(queue, 1, &sinfo, fence.get());
+			checkError(res);
+		}
+		auto waitForFence(const Fence& fence)
+		{
+			return vkWaitForFences(this->pInternal.get(), 1, &fence.get(), VK_TRUE, UINT64_MAX);
+		}
+		void present(const Swapchain& swapchain, uint32_t frameIndex)
+		{
+			VkPresentInfoKHR pinfo{};
+
+			pinfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+			pinfo.swapchainCount = 1;
+			pinfo.pSwapchains = &swapchain.get();
+			pinfo.pImageIndices = &frameIndex;
+
+			auto res = vkQueuePresentKHR(this->devQueue, &pinfo);
+			checkError(res);
+		}
+		void resetFence(const Fence& fence)
+		{
+			auto res = vkResetFences(this->pInternal.get(), 1, &fence.get());
+			checkError(res);
+		}
+	};
+
+	void dumpHostAllocatorStatistics(const TrackingAllocator& allocator)
+	{
+		const auto stats = allocator.statistics();
+
+		OutputDebugString(L"=== Host Allocation Statistics ===\n");
+		for (size_t i = 0; i < TrackingAllocator::ScopeCount; i++)
+		{
+			OutputDebugString(L"  "); OutputDebugStringA(TrackingAllocator::scopeName(i));
+			OutputDebugString(L": live "); OutputDebugString(std::to_wstring(stats.scopes[i].liveBytes).c_str());
+			OutputDebugString(L" bytes, peak "); OutputDebugString(std::to_wstring(stats.scopes[i].peakBytes).c_str());
+			OutputDebugString(L" bytes, "); OutputDebugString(std::to_wstring(stats.scopes[i].totalAllocations).c_str());
+			OutputDebugString(L" allocations\n");
+		}
+		OutputDebugString(L"  Total: live "); OutputDebugString(std::to_wstring(stats.liveBytes).c_str());
+		OutputDebugString(L" bytes, peak "); OutputDebugString(std::to_wstring(stats.peakBytes).c_str());
+		OutputDebugString(L" bytes, internal "); OutputDebugString(std::to_wstring(stats.internalBytes).c_str()); OutputDebugString(L" bytes\n");
+		OutputDebugString(L"  Command Arena: "); OutputDebugString(std::to_wstring(stats.arenaAllocations).c_str());
+		OutputDebugString(L" allocations, "); OutputDebugString(std::to_wstring(stats.arenaFallbacks).c_str());
+		OutputDebugString(L" fallbacks, "); OutputDebugString(std::to_wstring(stats.arenaResets).c_str()); OutputDebugString(L" resets\n");
+	}
+
+	void dumpPipelineStateCacheStatistics(const PipelineStateCache& cache)
+	{
+		const auto stats = cache.statistics();
+
+		OutputDebugString(L"=== Pipeline State Cache Statistics ===\n");
+		OutputDebugString(L"  Hit Rate: "); OutputDebugString(std::to_wstring(stats.hitRate() * 100.0).c_str());
+		OutputDebugString(L"% ("); OutputDebugString(std::to_wstring(stats.hits).c_str());
+		OutputDebugString(L" hits, "); OutputDebugString(std::to_wstring(stats.misses).c_str());
+		OutputDebugString(L" misses, "); OutputDebugString(std::to_wstring(stats.fallbacks).c_str()); OutputDebugString(L" fallbacks)\n");
+		OutputDebugString(L"  Compile: "); OutputDebugString(std::to_wstring(stats.compiles).c_str());
+		OutputDebugString(L" pipelines, avg "); OutputDebugString(std::to_wstring(stats.averageCompileMicroseconds()).c_str());
+		OutputDebugString(L" us, max "); OutputDebugString(std::to_wstring(stats.maxCompileMicroseconds).c_str()); OutputDebugString(L" us\n");
+	}
+
+	void initialImageLayouting(VkCommandBuffer buffer, const ImageArray& images, VkImageLayout layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR)
+	{
+		auto barriers = std::make_unique<VkImageMemoryBarrier[]>(size(images));
+
+		for (uint32_t i = 0; i < size(images); i++)
+		{
+			VkImageMemoryBarrier barrier{};
+
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = layout;
+			barrier.image = images.first[i];
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			barrier.subresourceRange.layerCount = 1;
+			barrier.subresourceRange.levelCount = 1;
+			barriers[i] = barrier;
+		}
+
+		vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			0, 0, nullptr, 0, nullptr, size(images), barriers.get());
+	}
+	void beginCommandWithFramebuffer(VkCommandBuffer buffer, const Framebuffer& fb)
+	{
+		VkCommandBufferInheritanceInfo inhInfo{};
+		VkCommandBufferBeginInfo beginInfo{};
+
+		inhInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inhInfo.framebuffer = fb.get();
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.pInheritanceInfo = &inhInfo;
+
+		vkBeginCommandBuffer(buffer, &beginInfo);
+	}
+	void barrierResource(VkCommandBuffer buffer, VkImage img,
+		VkPipelineStageFlags srcStageFlags, VkPipelineStageFlags dstStageFlags,
+		VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask,
+		VkImageLayout srcImageLayout, VkImageLayout dstImageLayout)
+	{
+		VkImageMemoryBarrier barrier{};
+
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.image = img;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.oldLayout = srcImageLayout;
+		barrier.newLayout = dstImageLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		vkCmdPipelineBarrier(buffer, srcStageFlags, dstStageFlags, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+	void barrierBuffer(VkCommandBuffer buffer, VkBuffer target,
+		VkPipelineStageFlags srcStageFlags, VkPipelineStageFlags dstStageFlags,
+		VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask)
+	{
+		VkBufferMemoryBarrier barrier{};
+
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.buffer = target;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(buffer, srcStageFlags, dstStageFlags, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+	void beginRenderPass(VkCommandBuffer buffer, const Framebuffer& frame, const RenderPass& renderPass)
+	{
+		static VkClearValue clearValue
+		{
+			{ 0.0f, 0.0f, 0.0f, 1.0f }
+		};
+		VkRenderPassBeginInfo rpinfo{};
+
+		rpinfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		rpinfo.framebuffer = frame.get();
+		rpinfo.renderPass = renderPass.get();
+		rpinfo.renderArea.extent.width = 640;
+		rpinfo.renderArea.extent.height = 480;
+		rpinfo.clearValueCount = 1;
+		rpinfo.pClearValues = &clearValue;
+		
+		vkCmdBeginRenderPass(buffer, &rpinfo, VK_SUBPASS_CONTENTS_INLINE);
+	}
+	// clearValues: one per attachment(RenderPassBuilder::clearValues)
+	void beginRenderPass(VkCommandBuffer buffer, const Framebuffer& frame, const RenderPass& renderPass,
+		const std::vector<VkClearValue>& clearValues, VkExtent2D extent = VkExtent2D{ 640, 480 })
+	{
+		VkRenderPassBeginInfo rpinfo{};
+
+		rpinfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		rpinfo.framebuffer = frame.get();
+		rpinfo.renderPass = renderPass.get();
+		rpinfo.renderArea.extent = extent;
+		rpinfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+		rpinfo.pClearValues = clearValues.data();
+
+		vkCmdBeginRenderPass(buffer, &rpinfo, VK_SUBPASS_CONTENTS_INLINE);
+	}
+}
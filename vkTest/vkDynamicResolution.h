@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#include "vkDevice.h"
+
+namespace Vulkan
+{
+	// Dynamic Resolution Controller
+	// Measures GPU frame time with timestamps and scales the render area so the frame fits in the budget.
+	// Over budget the scale drops at once(pixel cost is proportional to scale^2), so spikes cost pixels instead of frames;
+	// it only grows back after a run of frames well under budget.
+	// The render target is allocated at the maximum extent and only the render area changes, so nothing is recreated.
+	class DynamicResolution final
+	{
+	public:
+		struct Statistics
+		{
+			uint64_t frames, downscales, upscales;
+			double lastGpuMilliseconds, maxGpuMilliseconds, totalGpuMilliseconds;
+			double lowestScale, totalScale;
+
+			auto averageGpuMilliseconds() const { return frames == 0 ? 0.0 : totalGpuMilliseconds / static_cast<double>(frames); }
+			auto averageScale() const { return frames == 0 ? 1.0 : totalScale / static_cast<double>(frames); }
+		};
+	private:
+		static constexpr uint32_t GrowAfterFrames = 30;
+		static constexpr double GrowStep = 0.05;
+
+		struct FrameSlot
+		{
+			QueryPool pool;
+			bool pending;
+		};
+
+		VkDevice deviceRef;
+		bool enabled;
+		VkExtent2D maxExtent;
+		double budgetMilliseconds, minScale, scale;
+		double timestampPeriod;		// nanoseconds per tick
+		uint64_t timestampMask;
+		std::vector<FrameSlot> slots;
+		uint32_t currentSlot, stableFrames;
+		Statistics stats;
+
+		void collect(FrameSlot& s)
+		{
+			if (!s.pending) return;
+			s.pending = false;
+			uint64_t timestamps[2];
+			const auto res = vkGetQueryPoolResults(this->deviceRef, s.pool.get(), 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t),
+				VK_QUERY_RESULT_64_BIT);
+			if (res == VK_NOT_READY) return;
+			checkError(res);
+			const auto ticks = (timestamps[1] - timestamps[0]) & this->timestampMask;
+			this->update(static_cast<double>(ticks) * this->timestampPeriod / 1.0e6);
+		}
+	public:
+		// Disabled(always full extent) when the queue does not support timestamps
+		DynamicResolution(Device& device, VkExtent2D maxExtent, double budgetMilliseconds, double minScale = 0.5, uint32_t frameSlots = 2)
+			: deviceRef(device.handle()), enabled(false), maxExtent(maxExtent), budgetMilliseconds(budgetMilliseconds),
+			minScale(std::min(std::max(minScale, 0.1), 1.0)), scale(1.0), timestampPeriod(1.0), timestampMask(0),
+			currentSlot(0), stableFrames(0), stats{ 0, 0, 0, 0.0, 0.0, 0.0, 1.0, 0.0 }
+		{
+			VkPhysicalDeviceProperties props;
+			vkGetPhysicalDeviceProperties(device.physicalDevice(), &props);
+			uint32_t familyCount;
+			vkGetPhysicalDeviceQueueFamilyProperties(device.physicalDevice(), &familyCount, nullptr);
+			auto families = std::make_unique<VkQueueFamilyProperties[]>(familyCount);
+			vkGetPhysicalDeviceQueueFamilyProperties(device.physicalDevice(), &familyCount, families.get());
+			const auto validBits = families[device.queueFamily()].timestampValidBits;
+			if (validBits == 0) return;
+
+			this->enabled = true;
+			this->timestampPeriod = props.limits.timestampPeriod;
+			this->timestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+			for (uint32_t i = 0; i < frameSlots; i++)
+			{
+				this->slots.push_back(FrameSlot{ device.createQueryPool(VK_QUERY_TYPE_TIMESTAMP, 2), false });
+			}
+		}
+		DynamicResolution(const DynamicResolution&) = delete;
+
+		auto available() const { return this->enabled; }
+		auto currentScale() const { return this->scale; }
+		// Render area for this frame(multiple of 8, clamped to the maximum extent)
+		auto extent() const
+		{
+			const auto scaled = [](uint32_t size, double scale)
+			{
+				const auto s = (static_cast<uint32_t>(size * scale) + 7) & ~7u;
+				return std::min(std::max(s, 8u), size);
+			};
+			return VkExtent2D{ scaled(this->maxExtent.width, this->scale), scaled(this->maxExtent.height, this->scale) };
+		}
+
+		// Outside of render passes at the start/end of the measured commands
+		void beginFrame(VkCommandBuffer buffer)
+		{
+			if (!this->enabled) return;
+			auto& s = this->slots[this->currentSlot];
+			this->collect(s);
+			vkCmdResetQueryPool(buffer, s.pool.get(), 0, 2);
+			vkCmdWriteTimestamp(buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, s.pool.get(), 0);
+		}
+		void endFrame(VkCommandBuffer buffer)
+		{
+			if (!this->enabled) return;
+			auto& s = this->slots[this->currentSlot];
+			vkCmdWriteTimestamp(buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, s.pool.get(), 1);
+			s.pending = true;
+			this->currentSlot = (this->currentSlot + 1) % static_cast<uint32_t>(this->slots.size());
+		}
+
+		// Feeds one measured GPU frame time(called by beginFrame; public for other timing sources)
+		void update(double gpuMilliseconds)
+		{
+			if (gpuMilliseconds > this->budgetMilliseconds)
+			{
+				// aim slightly under budget so the next frame does not land on the edge
+				const auto target = this->scale * std::sqrt(this->budgetMilliseconds * 0.95 / gpuMilliseconds);
+				if (target < this->scale && this->scale > this->minScale) this->stats.downscales++;
+				this->scale = std::max(this->minScale, target);
+				this->stableFrames = 0;
+			}
+			else if (gpuMilliseconds < this->budgetMilliseconds * 0.8)
+			{
+				if (++this->stableFrames >= GrowAfterFrames && this->scale < 1.0)
+				{
+					this->scale = std::min(1.0, this->scale + GrowStep);
+					this->stableFrames = 0;
+					this->stats.upscales++;
+				}
+			}
+			else this->stableFrames = 0;
+
+			this->stats.frames++;
+			this->stats.lastGpuMilliseconds = gpuMilliseconds;
+			this->stats.maxGpuMilliseconds = std::max(this->stats.maxGpuMilliseconds, gpuMilliseconds);
+			this->stats.totalGpuMilliseconds += gpuMilliseconds;
+			this->stats.lowestScale = std::min(this->stats.lowestScale, this->scale);
+			this->stats.totalScale += this->scale;
+		}
+
+		auto statistics() const { return this->stats; }
+	};
+
+	// Upscale pass: stretches the rendered area of src(TRANSFER_SRC layout) over the whole dst(TRANSFER_DST layout)
+	void blitUpscale(VkCommandBuffer buffer, VkImage src, VkExtent2D srcExtent, VkImage dst, VkExtent2D dstExtent, VkFilter filter = VK_FILTER_LINEAR)
+	{
+		VkImageBlit region{};
+
+		region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.srcOffsets[1] = { static_cast<int32_t>(srcExtent.width), static_cast<int32_t>(srcExtent.height), 1 };
+		region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.dstOffsets[1] = { static_cast<int32_t>(dstExtent.width), static_cast<int32_t>(dstExtent.height), 1 };
+		vkCmdBlitImage(buffer, src, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, filter);
+	}
+
+	void dumpDynamicResolutionStatistics(const DynamicResolution& resolution)
+	{
+		const auto stats = resolution.statistics();
+
+		OutputDebugString(L"=== Dynamic Resolution Statistics ===\n");
+		if (!resolution.available()) { OutputDebugString(L"  Timestamps are not supported; rendered at full resolution\n"); return; }
+		OutputDebugString(L"  GPU Time: avg "); OutputDebugString(std::to_wstring(stats.averageGpuMilliseconds()).c_str());
+		OutputDebugString(L" ms, max "); OutputDebugString(std::to_wstring(stats.maxGpuMilliseconds).c_str());
+		OutputDebugString(L" ms, last "); OutputDebugString(std::to_wstring(stats.lastGpuMilliseconds).c_str()); OutputDebugString(L" ms\n");
+		OutputDebugString(L"  Scale: avg "); OutputDebugString(std::to_wstring(stats.averageScale()).c_str());
+		OutputDebugString(L", lowest "); OutputDebugString(std::to_wstring(stats.lowestScale).c_str());
+		OutputDebugString(L" ("); OutputDebugString(std::to_wstring(stats.downscales).c_str());
+		OutputDebugString(L" downscales, "); OutputDebugString(std::to_wstring(stats.upscales).c_str()); OutputDebugString(L" upscales)\n");
+	}
+}
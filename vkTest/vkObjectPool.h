@@ -0,0 +1,226 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "vkDevice.h"
+
+namespace Vulkan
+{
+	// Fence Pool
+	// Free list of unsignaled fences. acquire() hands out a Fence whose destroyer returns it to the pool;
+	// returned fences are reset together(one vkResetFences) when the free list runs dry.
+	// A fence must be returned only after it has signaled or if it was never submitted. The pool must outlive its handles.
+	class FencePool final
+	{
+	public:
+		struct Statistics
+		{
+			uint64_t created, acquired, resets;		// resets: vkResetFences calls
+		};
+	private:
+		Device& device;
+		mutable std::mutex lock;
+		std::vector<Fence> owned;
+		std::vector<VkFence> available, returned;
+		Statistics stats;
+
+		void release(VkFence fence)
+		{
+			std::lock_guard<std::mutex> l(this->lock);
+			this->returned.push_back(fence);
+		}
+	public:
+		FencePool(Device& device, uint32_t preallocate = 0) : device(device), stats{ 0, 0, 0 }
+		{
+			for (uint32_t i = 0; i < preallocate; i++)
+			{
+				this->owned.push_back(device.createFence());
+				this->available.push_back(this->owned.back().get());
+				this->stats.created++;
+			}
+		}
+		FencePool(const FencePool&) = delete;
+
+		Fence acquire()
+		{
+			std::lock_guard<std::mutex> l(this->lock);
+			if (this->available.empty() && !this->returned.empty())
+			{
+				auto res = vkResetFences(this->device.handle(), static_cast<uint32_t>(this->returned.size()), this->returned.data());
+				checkError(res);
+				this->available.swap(this->returned);
+				this->stats.resets++;
+			}
+			if (this->available.empty())
+			{
+				this->owned.push_back(this->device.createFence());
+				this->available.push_back(this->owned.back().get());
+				this->stats.created++;
+			}
+			const auto fence = this->available.back();
+			this->available.pop_back();
+			this->stats.acquired++;
+			return Fence(this->device.handle(), fence, [this](VkDevice, VkFence f, const VkAllocationCallbacks*) { this->release(f); });
+		}
+
+		auto statistics() const
+		{
+			std::lock_guard<std::mutex> l(this->lock);
+			return this->stats;
+		}
+	};
+
+	// Semaphore Pool
+	// Free list of semaphores; a semaphore must be returned unsignaled with no pending wait(i.e. after the waiting submission completed).
+	class SemaphorePool final
+	{
+	public:
+		struct Statistics
+		{
+			uint64_t created, acquired;
+		};
+	private:
+		Device& device;
+		mutable std::mutex lock;
+		std::vector<Semaphore> owned;
+		std::vector<VkSemaphore> available;
+		Statistics stats;
+
+		void release(VkSemaphore semaphore)
+		{
+			std::lock_guard<std::mutex> l(this->lock);
+			this->available.push_back(semaphore);
+		}
+	public:
+		SemaphorePool(Device& device) : device(device), stats{ 0, 0 } {}
+		SemaphorePool(const SemaphorePool&) = delete;
+
+		Semaphore acquire()
+		{
+			std::lock_guard<std::mutex> l(this->lock);
+			if (this->available.empty())
+			{
+				this->owned.push_back(this->device.createSemaphore());
+				this->available.push_back(this->owned.back().get());
+				this->stats.created++;
+			}
+			const auto semaphore = this->available.back();
+			this->available.pop_back();
+			this->stats.acquired++;
+			return Semaphore(this->device.handle(), semaphore, [this](VkDevice, VkSemaphore s, const VkAllocationCallbacks*) { this->release(s); });
+		}
+
+		auto statistics() const
+		{
+			std::lock_guard<std::mutex> l(this->lock);
+			return this->stats;
+		}
+	};
+
+	// Command Buffer Pool
+	// Primary command buffers recycled through a free list over one VkCommandPool; use one pool per recording thread
+	// (command pools are externally synchronized). A submitted buffer is retired together with the fence of its submission
+	// and both return to their pools once the fence has signaled; vkBeginCommandBuffer resets recycled buffers implicitly.
+	// Dropping a CommandBuffer handle returns it immediately, so only do that when its commands are not pending.
+	class CommandBufferPool final
+	{
+	public:
+		struct Statistics
+		{
+			uint64_t allocated, acquired, recycled;
+		};
+	private:
+		struct InFlight
+		{
+			CommandBuffer buffer;
+			Fence fence;
+			Semaphore waited;
+		};
+
+		VkDevice deviceRef;
+		CommandPool pool;
+		std::vector<VkCommandBuffer> allocated, available;
+		std::deque<InFlight> inFlight;
+		Statistics stats;
+	public:
+		CommandBufferPool(Device& device) : CommandBufferPool(device, device.queueFamily()) {}
+		// Buffers for queues of queueFamily(e.g. Device::computeQueueFamily())
+		CommandBufferPool(Device& device, uint32_t queueFamily) : deviceRef(device.handle()), pool(device.createCommandPool(queueFamily)), stats{ 0, 0, 0 } {}
+		CommandBufferPool(const CommandBufferPool&) = delete;
+		~CommandBufferPool()
+		{
+			for (const auto& f : this->inFlight) vkWaitForFences(this->deviceRef, 1, &f.fence.get(), VK_TRUE, UINT64_MAX);
+			this->inFlight.clear();
+			if (!this->allocated.empty())
+			{
+				vkFreeCommandBuffers(this->deviceRef, this->pool.get(), static_cast<uint32_t>(this->allocated.size()), this->allocated.data());
+			}
+		}
+
+		CommandBuffer acquire()
+		{
+			this->recycle();
+			if (this->available.empty())
+			{
+				VkCommandBufferAllocateInfo cbAllocInfo{};
+
+				cbAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				cbAllocInfo.commandPool = this->pool.get();
+				cbAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+				cbAllocInfo.commandBufferCount = 1;
+
+				VkCommandBuffer buffer;
+				auto res = vkAllocateCommandBuffers(this->deviceRef, &cbAllocInfo, &buffer);
+				checkError(res);
+				this->allocated.push_back(buffer);
+				this->available.push_back(buffer);
+				this->stats.allocated++;
+			}
+			const auto buffer = this->available.back();
+			this->available.pop_back();
+			this->stats.acquired++;
+			return CommandBuffer(this->deviceRef, buffer, [this](VkDevice, VkCommandBuffer b, const VkAllocationCallbacks*) { this->available.push_back(b); });
+		}
+		// Keeps buffer and fence(and the semaphore the submission waited on) alive until the fence signals
+		void retire(CommandBuffer&& buffer, Fence&& fence, Semaphore&& waited = Semaphore())
+		{
+			this->inFlight.push_back(InFlight{ std::move(buffer), std::move(fence), std::move(waited) });
+		}
+		// Returns buffers of completed submissions to the free list(in submission order; called by acquire)
+		uint32_t recycle()
+		{
+			uint32_t count = 0;
+			while (!this->inFlight.empty())
+			{
+				const auto res = vkGetFenceStatus(this->deviceRef, this->inFlight.front().fence.get());
+				if (res == VK_NOT_READY) break;
+				checkError(res);
+				this->inFlight.pop_front();
+				count++;
+			}
+			this->stats.recycled += count;
+			return count;
+		}
+
+		auto inFlightCount() const { return static_cast<uint32_t>(this->inFlight.size()); }
+		auto statistics() const { return this->stats; }
+	};
+
+	void dumpObjectPoolStatistics(const FencePool& fences, const CommandBufferPool& commandBuffers)
+	{
+		const auto fenceStats = fences.statistics();
+		const auto bufferStats = commandBuffers.statistics();
+
+		OutputDebugString(L"=== Object Pool Statistics ===\n");
+		OutputDebugString(L"  Fences: "); OutputDebugString(std::to_wstring(fenceStats.created).c_str());
+		OutputDebugString(L" created for "); OutputDebugString(std::to_wstring(fenceStats.acquired).c_str());
+		OutputDebugString(L" acquisitions, "); OutputDebugString(std::to_wstring(fenceStats.resets).c_str()); OutputDebugString(L" batched resets\n");
+		OutputDebugString(L"  Command Buffers: "); OutputDebugString(std::to_wstring(bufferStats.allocated).c_str());
+		OutputDebugString(L" allocated for "); OutputDebugString(std::to_wstring(bufferStats.acquired).c_str());
+		OutputDebugString(L" acquisitions, "); OutputDebugString(std::to_wstring(bufferStats.recycled).c_str());
+		OutputDebugString(L" recycled on fence completion, "); OutputDebugString(std::to_wstring(commandBuffers.inFlightCount()).c_str());
+		OutputDebugString(L" in flight\n");
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "vkDevice.h"
+
+namespace Vulkan
+{
+	// GPU Particle Simulation
+	// A compute shader integrates particles in storage buffers that are also bound as vertex buffers(VertexData layout:
+	// pos[2], color[4] as floats), so geometry never goes through the CPU. Initial positions are generated on the GPU too.
+	// Single-buffered: updated in place, the draw of a frame waits for its simulation.
+	// Double-buffered: each step reads the buffer drawn last frame and writes the other one.
+	class ParticleSystem final
+	{
+	public:
+		static constexpr uint32_t WorkgroupSize = 256;		// local_size_x of Particles.comp
+		static constexpr VkDeviceSize VertexStride = sizeof(float) * 6;
+	private:
+		struct Parameters
+		{
+			float deltaTime;
+			uint32_t particleCount, reset;
+		};
+
+		uint32_t count;
+		bool doubleBuffered, initialized;
+		uint32_t current;		// buffer holding the latest simulation result
+		std::vector<BufferData> vertices;
+		BufferData velocities;
+		DescriptorSetLayout setLayout;
+		PipelineLayout layout;
+		DescriptorPool descriptorPool;
+		std::vector<VkDescriptorSet> sets;		// [i]: reads vertices[i], writes vertices[next(i)]
+		ShaderModule shader;
+		Pipeline pipeline;
+
+		auto next(uint32_t index) const { return this->doubleBuffered ? 1 - index : index; }
+	public:
+		// Highest particle count not above requested whose buffers fit a storage buffer binding and that one dispatch covers
+		static uint32_t supportedCount(const Device& device, uint32_t requested)
+		{
+			VkPhysicalDeviceProperties props;
+			vkGetPhysicalDeviceProperties(device.physicalDevice(), &props);
+			const auto rangeLimit = props.limits.maxStorageBufferRange / VertexStride;		// vertex data is the largest binding
+			const auto dispatchLimit = static_cast<uint64_t>(props.limits.maxComputeWorkGroupCount[0]) * WorkgroupSize;
+			return static_cast<uint32_t>(std::min({ static_cast<uint64_t>(requested), rangeLimit, dispatchLimit }));
+		}
+
+		// count is clamped to supportedCount
+		ParticleSystem(Device& device, const PipelineCache& cache, uint32_t count, bool doubleBuffered,
+			const std::wstring& shaderPath = L"Particles.comp.spv")
+			: count(supportedCount(device, count)), doubleBuffered(doubleBuffered), initialized(false), current(0)
+		{
+			const auto bufferCount = doubleBuffered ? 2u : 1u;
+			for (uint32_t i = 0; i < bufferCount; i++)
+			{
+				this->vertices.push_back(device.createBuffer(VertexStride * this->count,
+					VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+			}
+			this->velocities = device.createBuffer(sizeof(float) * 2 * this->count, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+			std::vector<VkDescriptorSetLayoutBinding> bindings;
+			for (uint32_t b = 0; b < 3; b++) bindings.push_back(VkDescriptorSetLayoutBinding{ b, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr });
+			this->setLayout = device.createDescriptorSetLayout(bindings);
+			this->layout = device.createPipelineLayout({ this->setLayout.get() },
+				{ VkPushConstantRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Parameters) } });
+			this->descriptorPool = device.createDescriptorPool(bufferCount, { VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * bufferCount } });
+			for (uint32_t i = 0; i < bufferCount; i++)
+			{
+				this->sets.push_back(device.allocateDescriptorSet(this->descriptorPool, this->setLayout));
+				device.updateStorageBuffers(this->sets.back(),
+					{ this->vertices[i].first.get(), this->vertices[this->next(i)].first.get(), this->velocities.first.get() });
+			}
+
+			this->shader = device.createShaderModule(shaderPath);
+			this->pipeline = device.createComputePipeline(this->shader, this->layout, cache);
+		}
+		ParticleSystem(const ParticleSystem&) = delete;
+
+		// Records one simulation step(outside of render passes); the first call scatters the initial particles
+		void simulate(VkCommandBuffer buffer, float deltaTime)
+		{
+			const auto src = this->current, dst = this->next(this->current);
+			const Parameters params{ deltaTime, this->count, this->initialized ? 0u : 1u };
+
+			// Previous draws must be done reading and previous steps done writing before this step reads/overwrites
+			const auto beforeStep = [buffer](VkBuffer target)
+			{
+				barrierBuffer(buffer, target, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+			};
+			beforeStep(this->vertices[dst].first.get());
+			if (src != dst) beforeStep(this->vertices[src].first.get());
+			beforeStep(this->velocities.first.get());
+			vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->pipeline.get());
+			vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->layout.get(), 0, 1, &this->sets[src], 0, nullptr);
+			vkCmdPushConstants(buffer, this->layout.get(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(Parameters), &params);
+			vkCmdDispatch(buffer, (this->count + WorkgroupSize - 1) / WorkgroupSize, 1, 1);
+			// RAW: vertex input reads what compute wrote
+			barrierBuffer(buffer, this->vertices[dst].first.get(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+				VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+
+			this->current = dst;
+			this->initialized = true;
+		}
+
+		// Vertex buffer written by the last simulate()
+		auto vertexBuffer() const { return this->vertices[this->current].first.get(); }
+		auto particleCount() const { return this->count; }
+		auto isDoubleBuffered() const { return this->doubleBuffered; }
+	};
+}
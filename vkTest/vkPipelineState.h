@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cstring>
+#include <vector>
+#include <functional>
+#include <utility>
+
+namespace Vulkan
+{
+	enum class BlendMode : uint32_t { Opaque, Alpha, Additive };
+
+	// Compact description of fixed-function graphics pipeline state (packed in 32 bits)
+	// [0:3] topology, [4:5] polygon mode, [6:7] cull mode, [8] front face, [9:10] blend mode,
+	// [11:13] log2(samples), [14] depth test, [15] depth write
+	class PipelineStateKey final
+	{
+		uint32_t bits;
+
+		static constexpr uint32_t log2(uint32_t v) { return v <= 1 ? 0 : 1 + log2(v >> 1); }
+		constexpr uint32_t field(uint32_t shift, uint32_t mask) const { return (bits >> shift) & mask; }
+	public:
+		constexpr PipelineStateKey() : bits(0) {}
+		explicit constexpr PipelineStateKey(uint32_t b) : bits(b) {}
+		static constexpr PipelineStateKey make(VkPrimitiveTopology topology, VkCullModeFlags cullMode = VK_CULL_MODE_NONE,
+			BlendMode blend = BlendMode::Opaque, VkSampleCountFlags samples = VK_SAMPLE_COUNT_1_BIT,
+			VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL, VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+			bool depthTest = false, bool depthWrite = false)
+		{
+			return PipelineStateKey((static_cast<uint32_t>(topology) & 0x0f)
+				| ((static_cast<uint32_t>(polygonMode) & 0x03) << 4)
+				| ((static_cast<uint32_t>(cullMode) & 0x03) << 6)
+				| ((static_cast<uint32_t>(frontFace) & 0x01) << 8)
+				| ((static_cast<uint32_t>(blend) & 0x03) << 9)
+				| ((log2(samples) & 0x07) << 11)
+				| ((depthTest ? 1u : 0u) << 14)
+				| ((depthWrite ? 1u : 0u) << 15));
+		}
+
+		constexpr uint32_t packed() const { return bits; }
+		constexpr auto topology() const { return static_cast<VkPrimitiveTopology>(field(0, 0x0f)); }
+		constexpr auto polygonMode() const { return static_cast<VkPolygonMode>(field(4, 0x03)); }
+		constexpr auto cullMode() const { return static_cast<VkCullModeFlags>(field(6, 0x03)); }
+		constexpr auto frontFace() const { return static_cast<VkFrontFace>(field(8, 0x01)); }
+		constexpr auto blendMode() const { return static_cast<BlendMode>(field(9, 0x03)); }
+		constexpr auto samples() const { return static_cast<VkSampleCountFlagBits>(1u << field(11, 0x07)); }
+		constexpr bool depthTest() const { return field(14, 0x01) != 0; }
+		constexpr bool depthWrite() const { return field(15, 0x01) != 0; }
+		// Same state with a different sample count
+		constexpr PipelineStateKey withSamples(VkSampleCountFlags samples) const { return PipelineStateKey((bits & ~(0x07u << 11)) | ((log2(samples) & 0x07) << 11)); }
+
+		constexpr bool operator==(const PipelineStateKey& k) const { return bits == k.bits; }
+		constexpr bool operator!=(const PipelineStateKey& k) const { return bits != k.bits; }
+
+		// Expands to Vulkan create info structures
+		void apply(VkPipelineInputAssemblyStateCreateInfo& iaInfo, VkPipelineRasterizationStateCreateInfo& rasterizerStateInfo,
+			VkPipelineMultisampleStateCreateInfo& msInfo, VkPipelineDepthStencilStateCreateInfo& dsInfo,
+			VkPipelineColorBlendAttachmentState& blendState) const
+		{
+			iaInfo.topology = this->topology();
+			rasterizerStateInfo.polygonMode = this->polygonMode();
+			rasterizerStateInfo.cullMode = this->cullMode();
+			rasterizerStateInfo.frontFace = this->frontFace();
+			msInfo.rasterizationSamples = this->samples();
+			dsInfo.depthTestEnable = this->depthTest() ? VK_TRUE : VK_FALSE;
+			dsInfo.depthWriteEnable = this->depthWrite() ? VK_TRUE : VK_FALSE;
+			dsInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+			switch (this->blendMode())
+			{
+			case BlendMode::Alpha:
+				blendState.blendEnable = VK_TRUE;
+				blendState.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+				blendState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+				blendState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+				blendState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+				break;
+			case BlendMode::Additive:
+				blendState.blendEnable = VK_TRUE;
+				blendState.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+				blendState.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+				blendState.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+				blendState.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+				break;
+			default:
+				blendState.blendEnable = VK_FALSE;
+			}
+			blendState.colorBlendOp = VK_BLEND_OP_ADD;
+			blendState.alphaBlendOp = VK_BLEND_OP_ADD;
+		}
+	};
+
+	// Compile-time pipeline variant
+	template<VkPrimitiveTopology Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST, VkCullModeFlags CullMode = VK_CULL_MODE_NONE,
+		BlendMode Blend = BlendMode::Opaque, VkSampleCountFlags Samples = VK_SAMPLE_COUNT_1_BIT>
+	struct PipelineVariant
+	{
+		static constexpr PipelineStateKey key() { return PipelineStateKey::make(Topology, CullMode, Blend, Samples); }
+		// For render passes whose sample count is only known at runtime
+		static constexpr PipelineStateKey key(VkSampleCountFlags samples) { return key().withSamples(samples); }
+	};
+
+	// Specialization Constants(all 32-bit: bool as VkBool32, int, uint and float)
+	// constantID is assigned sequentially from 0 in declaration order
+	template<uint32_t... Values> struct StaticSpecialization
+	{
+	private:
+		template<size_t... Indices> static auto mapEntries(std::index_sequence<Indices...>)
+		{
+			static const VkSpecializationMapEntry entries[] =
+			{
+				VkSpecializationMapEntry{ static_cast<uint32_t>(Indices), static_cast<uint32_t>(Indices * sizeof(uint32_t)), sizeof(uint32_t) }...
+			};
+			return entries;
+		}
+	public:
+		static const VkSpecializationInfo* info()
+		{
+			static const uint32_t data[] = { Values... };
+			static const VkSpecializationInfo specInfo
+			{
+				static_cast<uint32_t>(sizeof...(Values)), mapEntries(std::make_index_sequence<sizeof...(Values)>()), sizeof(data), data
+			};
+			return &specInfo;
+		}
+	};
+	template<> struct StaticSpecialization<>
+	{
+		static const VkSpecializationInfo* info() { return nullptr; }
+	};
+
+	// Runtime-built Specialization Constants(for values not expressible as template arguments, e.g. float)
+	class SpecializationData final
+	{
+		std::vector<uint32_t> values;
+		std::vector<VkSpecializationMapEntry> entries;
+	public:
+		SpecializationData() = default;
+		// Copies contents of an existing VkSpecializationInfo(e.g. StaticSpecialization<...>::info())
+		static SpecializationData from(const VkSpecializationInfo* info)
+		{
+			SpecializationData data;
+			if (info == nullptr) return data;
+			for (uint32_t i = 0; i < info->mapEntryCount; i++)
+			{
+				uint32_t raw = 0;
+				const auto& e = info->pMapEntries[i];
+				memcpy(&raw, reinterpret_cast<const uint8_t*>(info->pData) + e.offset, e.size < sizeof raw ? e.size : sizeof raw);
+				data.set(e.constantID, raw);
+			}
+			return data;
+		}
+
+		template<typename T> SpecializationData& set(uint32_t constantID, T value)
+		{
+			static_assert(sizeof(T) == sizeof(uint32_t), "Specialization constants must be 32-bit");
+			uint32_t raw;
+			memcpy(&raw, &value, sizeof raw);
+			for (size_t i = 0; i < this->entries.size(); i++)
+			{
+				if (this->entries[i].constantID == constantID)
+				{
+					this->values[i] = raw;
+					return *this;
+				}
+			}
+			this->entries.push_back(VkSpecializationMapEntry{ constantID, static_cast<uint32_t>(this->values.size() * sizeof(uint32_t)), sizeof(uint32_t) });
+			this->values.push_back(raw);
+			return *this;
+		}
+		SpecializationData& set(uint32_t constantID, bool value) { return this->set(constantID, static_cast<VkBool32>(value ? VK_TRUE : VK_FALSE)); }
+
+		bool empty() const noexcept { return this->entries.empty(); }
+		// The returned structure points into this object
+		auto info() const
+		{
+			VkSpecializationInfo specInfo{};
+			specInfo.mapEntryCount = static_cast<uint32_t>(this->entries.size());
+			specInfo.pMapEntries = this->entries.data();
+			specInfo.dataSize = this->values.size() * sizeof(uint32_t);
+			specInfo.pData = this->values.data();
+			return specInfo;
+		}
+
+		size_t hash() const
+		{
+			size_t h = this->entries.size();
+			for (size_t i = 0; i < this->entries.size(); i++)
+			{
+				h ^= this->entries[i].constantID + 0x9e3779b9 + (h << 6) + (h >> 2);
+				h ^= this->values[i] + 0x9e3779b9 + (h << 6) + (h >> 2);
+			}
+			return h;
+		}
+		bool operator==(const SpecializationData& s) const
+		{
+			if (this->values != s.values || this->entries.size() != s.entries.size()) return false;
+			for (size_t i = 0; i < this->entries.size(); i++)
+			{
+				if (this->entries[i].constantID != s.entries[i].constantID) return false;
+			}
+			return true;
+		}
+	};
+
+	// Full description of a graphics pipeline(vertex + fragment)
+	struct GraphicsPipelineDesc
+	{
+		VkShaderModule vertexShader, fragmentShader;
+		SpecializationData vertexSpec, fragmentSpec;
+		std::vector<VkVertexInputBindingDescription> vertexBindings;
+		std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+		PipelineStateKey state;
+		VkPipelineLayout layout;
+		VkRenderPass renderPass;
+		uint32_t subpass;
+
+		GraphicsPipelineDesc() : vertexShader(VK_NULL_HANDLE), fragmentShader(VK_NULL_HANDLE), layout(VK_NULL_HANDLE), renderPass(VK_NULL_HANDLE), subpass(0) {}
+
+		size_t hash() const
+		{
+			size_t h = 0;
+			const auto combine = [&h](size_t v) { h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2); };
+			combine(std::hash<VkShaderModule>()(this->vertexShader));
+			combine(std::hash<VkShaderModule>()(this->fragmentShader));
+			combine(this->vertexSpec.hash());
+			combine(this->fragmentSpec.hash());
+			for (const auto& b : this->vertexBindings)
+			{
+				combine(b.binding); combine(b.stride); combine(b.inputRate);
+			}
+			for (const auto& a : this->vertexAttributes)
+			{
+				combine(a.location); combine(a.binding); combine(a.format); combine(a.offset);
+			}
+			combine(this->state.packed());
+			combine(std::hash<VkPipelineLayout>()(this->layout));
+			combine(std::hash<VkRenderPass>()(this->renderPass));
+			combine(this->subpass);
+			return h;
+		}
+		bool operator==(const GraphicsPipelineDesc& d) const
+		{
+			if (this->vertexShader != d.vertexShader || this->fragmentShader != d.fragmentShader) return false;
+			if (!(this->vertexSpec == d.vertexSpec) || !(this->fragmentSpec == d.fragmentSpec)) return false;
+			if (this->state != d.state || this->layout != d.layout || this->renderPass != d.renderPass || this->subpass != d.subpass) return false;
+			if (this->vertexBindings.size() != d.vertexBindings.size() || this->vertexAttributes.size() != d.vertexAttributes.size()) return false;
+			for (size_t i = 0; i < this->vertexBindings.size(); i++)
+			{
+				const auto& a = this->vertexBindings[i];
+				const auto& b = d.vertexBindings[i];
+				if (a.binding != b.binding || a.stride != b.stride || a.inputRate != b.inputRate) return false;
+			}
+			for (size_t i = 0; i < this->vertexAttributes.size(); i++)
+			{
+				const auto& a = this->vertexAttributes[i];
+				const auto& b = d.vertexAttributes[i];
+				if (a.location != b.location || a.binding != b.binding || a.format != b.format || a.offset != b.offset) return false;
+			}
+			return true;
+		}
+	};
+}
+
+namespace std
+{
+	template<> struct hash<Vulkan::PipelineStateKey>
+	{
+		size_t operator()(const Vulkan::PipelineStateKey& k) const noexcept { return std::hash<uint32_t>()(k.packed()); }
+	};
+	template<> struct hash<Vulkan::GraphicsPipelineDesc>
+	{
+		size_t operator()(const Vulkan::GraphicsPipelineDesc& d) const { return d.hash(); }
+	};
+}
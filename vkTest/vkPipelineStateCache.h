@@ -0,0 +1,203 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+
+#include "vkPipelineState.h"
+
+namespace Vulkan
+{
+	// Pipeline State Object Cache
+	// Pipelines are shared between all requests with an identical GraphicsPipelineDesc.
+	// The map is split into shards each guarded by its own mutex, so lookups from different threads rarely contend.
+	// Keys hold raw shader module/render pass/layout handles: before destroying one of them while the cache lives,
+	// evict the entries referencing it(evictIf), or a new object reusing the handle value would hit a stale pipeline.
+	// A failed compilation is rethrown once to the caller that observes it and the entry is dropped, so the next request retries.
+	class PipelineStateCache final
+	{
+	public:
+		using PipelineRef = std::shared_ptr<Pipeline>;
+		using CompilerT = std::function<Pipeline(const GraphicsPipelineDesc&)>;
+
+		struct Statistics
+		{
+			uint64_t hits, misses, compiles, pendingHits, fallbacks;
+			uint64_t totalCompileMicroseconds, maxCompileMicroseconds;
+
+			auto hitRate() const { return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses); }
+			auto averageCompileMicroseconds() const { return compiles == 0 ? 0.0 : static_cast<double>(totalCompileMicroseconds) / static_cast<double>(compiles); }
+		};
+	private:
+		static constexpr size_t ShardCount = 16;
+
+		struct Entry
+		{
+			PipelineRef pipeline;
+			std::shared_future<PipelineRef> pending;
+		};
+		struct Shard
+		{
+			std::mutex lock;
+			std::unordered_map<GraphicsPipelineDesc, Entry> entries;
+		};
+
+		CompilerT compiler;
+		Shard shards[ShardCount];
+		std::atomic<uint64_t> hits, misses, compiles, pendingHits, fallbacks;
+		std::atomic<uint64_t> totalCompileMicroseconds, maxCompileMicroseconds;
+
+		auto& shardOf(size_t hash) { return this->shards[(hash >> 4) % ShardCount]; }
+
+		PipelineRef compile(const GraphicsPipelineDesc& desc)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+			auto pipeline = std::make_shared<Pipeline>(this->compiler(desc));
+			const auto us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count());
+
+			this->compiles.fetch_add(1, std::memory_order_relaxed);
+			this->totalCompileMicroseconds.fetch_add(us, std::memory_order_relaxed);
+			auto currentMax = this->maxCompileMicroseconds.load(std::memory_order_relaxed);
+			while (currentMax < us && !this->maxCompileMicroseconds.compare_exchange_weak(currentMax, us, std::memory_order_relaxed));
+			return pipeline;
+		}
+		// Resolves a finished pending compile(called with shard lock held).
+		// A failed compile erases the entry and rethrows its exception.
+		template<typename IteratorT> static bool resolve(Shard& shard, IteratorT found)
+		{
+			auto& e = found->second;
+			if (e.pipeline) return true;
+			if (!e.pending.valid() || e.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+			try { e.pipeline = e.pending.get(); }
+			catch (...)
+			{
+				shard.entries.erase(found);
+				throw;
+			}
+			e.pending = std::shared_future<PipelineRef>();
+			return true;
+		}
+	public:
+		PipelineStateCache(CompilerT compiler)
+			: compiler(std::move(compiler)), hits(0), misses(0), compiles(0), pendingHits(0), fallbacks(0),
+			totalCompileMicroseconds(0), maxCompileMicroseconds(0) {}
+		PipelineStateCache(const PipelineStateCache&) = delete;
+		~PipelineStateCache() { this->waitIdle(); }
+
+		// Returns the cached pipeline, or compiles it on the calling thread
+		PipelineRef get(const GraphicsPipelineDesc& desc)
+		{
+			auto& shard = this->shardOf(desc.hash());
+			std::unique_lock<std::mutex> l(shard.lock);
+			auto found = shard.entries.find(desc);
+			if (found != shard.entries.end())
+			{
+				if (resolve(shard, found))
+				{
+					this->hits.fetch_add(1, std::memory_order_relaxed);
+					return found->second.pipeline;
+				}
+				// compiling on another thread
+				this->pendingHits.fetch_add(1, std::memory_order_relaxed);
+				auto pending = found->second.pending;
+				l.unlock();
+				return pending.get();
+			}
+
+			this->misses.fetch_add(1, std::memory_order_relaxed);
+			std::promise<PipelineRef> promise;
+			auto pending = promise.get_future().share();
+			shard.entries[desc].pending = pending;
+			l.unlock();
+			try { promise.set_value(this->compile(desc)); }
+			catch (...)
+			{
+				promise.set_exception(std::current_exception());
+				l.lock();
+				shard.entries.erase(desc);
+				throw;
+			}
+			return pending.get();
+		}
+		// Returns the cached pipeline if available. On miss compilation starts on a background thread
+		// and fallback(may be empty) is returned until it finishes.
+		PipelineRef request(const GraphicsPipelineDesc& desc, const PipelineRef& fallback = PipelineRef())
+		{
+			auto& shard = this->shardOf(desc.hash());
+			std::lock_guard<std::mutex> l(shard.lock);
+			auto found = shard.entries.find(desc);
+			if (found != shard.entries.end())
+			{
+				if (resolve(shard, found))
+				{
+					this->hits.fetch_add(1, std::memory_order_relaxed);
+					return found->second.pipeline;
+				}
+				this->pendingHits.fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+			{
+				this->misses.fetch_add(1, std::memory_order_relaxed);
+				shard.entries[desc].pending = std::async(std::launch::async, [this, desc]() { return this->compile(desc); }).share();
+			}
+			this->fallbacks.fetch_add(1, std::memory_order_relaxed);
+			return fallback;
+		}
+
+		// Waits all background compilations
+		void waitIdle()
+		{
+			for (auto& shard : this->shards)
+			{
+				std::lock_guard<std::mutex> l(shard.lock);
+				for (auto& e : shard.entries)
+				{
+					if (e.second.pending.valid()) e.second.pending.wait();
+				}
+			}
+		}
+		// Drops the entries matching pred(const GraphicsPipelineDesc&), e.g. those referencing an object about to be destroyed.
+		// Returns the number of evicted entries.
+		template<typename PredT> size_t evictIf(PredT pred)
+		{
+			size_t count = 0;
+			for (auto& shard : this->shards)
+			{
+				std::lock_guard<std::mutex> l(shard.lock);
+				for (auto it = shard.entries.begin(); it != shard.entries.end();)
+				{
+					if (!pred(it->first)) { ++it; continue; }
+					if (it->second.pending.valid()) it->second.pending.wait();
+					it = shard.entries.erase(it);
+					count++;
+				}
+			}
+			return count;
+		}
+		// Drops all pipelines(callers holding references keep them alive)
+		void clear()
+		{
+			this->waitIdle();
+			for (auto& shard : this->shards)
+			{
+				std::lock_guard<std::mutex> l(shard.lock);
+				shard.entries.clear();
+			}
+		}
+
+		auto statistics() const
+		{
+			return Statistics
+			{
+				this->hits.load(std::memory_order_relaxed), this->misses.load(std::memory_order_relaxed),
+				this->compiles.load(std::memory_order_relaxed), this->pendingHits.load(std::memory_order_relaxed),
+				this->fallbacks.load(std::memory_order_relaxed),
+				this->totalCompileMicroseconds.load(std::memory_order_relaxed), this->maxCompileMicroseconds.load(std::memory_order_relaxed)
+			};
+		}
+	};
+}
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <deque>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+
+#include "vkDevice.h"
+
+namespace Vulkan
+{
+	// Pipeline Statistics Collector
+	// Counters are gathered per render pass and per tagged draw group.
+	// Only one pipeline statistics query may be active at a time, so a draw group splits its enclosing pass into segments;
+	// the pass reports the sum of all of its segments(groups included).
+	// Results are read back when a frame slot is reused, so no wait is introduced into the frame.
+	class PipelineStatistics final
+	{
+	public:
+		struct Counters
+		{
+			uint64_t iaVertices, iaPrimitives, vsInvocations, clippingPrimitives, fsInvocations;
+
+			void add(const Counters& c)
+			{
+				this->iaVertices += c.iaVertices;
+				this->iaPrimitives += c.iaPrimitives;
+				this->vsInvocations += c.vsInvocations;
+				this->clippingPrimitives += c.clippingPrimitives;
+				this->fsInvocations += c.fsInvocations;
+			}
+		};
+		enum class Bottleneck { Balanced, Vertex, Raster, Fill };
+		struct Sample
+		{
+			uint64_t frame;
+			double seconds;		// since the collector was created
+			std::string name;
+			bool group;
+			uint64_t pixels;	// render area of the pass(or the enclosing pass)
+			Counters counters;
+		};
+	private:
+		// Results are written in bit order, which matches the field order of Counters
+		static constexpr VkQueryPipelineStatisticFlags CollectedStatistics = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT
+			| VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT | VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+			| VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+		static constexpr uint32_t NoScope = UINT32_MAX;
+
+		struct Scope
+		{
+			std::string name;
+			bool group;
+			uint32_t pass;		// enclosing pass scope of a group
+			uint64_t pixels;
+		};
+		struct FrameSlot
+		{
+			QueryPool pool;
+			std::vector<uint32_t> segmentScopes;	// query index -> scope
+			std::vector<Scope> scopes;
+			uint64_t frame;
+			bool pending;
+		};
+
+		VkDevice deviceRef;
+		bool enabled;
+		uint32_t maxSegments;
+		std::vector<FrameSlot> slots;
+		uint32_t currentSlot;
+		uint64_t frameNumber, overflows, dropped;
+		VkCommandBuffer recording;
+		uint32_t activePass, activeGroup;
+		bool segmentOpen;
+		std::chrono::steady_clock::time_point startTime;
+		std::deque<Sample> samples;
+		size_t historyLimit;
+		BinaryLoader::File exportFile;
+
+		auto& slot() { return this->slots[this->currentSlot]; }
+		void openSegment(uint32_t scope)
+		{
+			auto& s = this->slot();
+			if (s.segmentScopes.size() >= this->maxSegments) { this->overflows++; return; }
+			vkCmdBeginQuery(this->recording, s.pool.get(), static_cast<uint32_t>(s.segmentScopes.size()), 0);
+			s.segmentScopes.push_back(scope);
+			this->segmentOpen = true;
+		}
+		void closeSegment()
+		{
+			if (!this->segmentOpen) return;
+			auto& s = this->slot();
+			vkCmdEndQuery(this->recording, s.pool.get(), static_cast<uint32_t>(s.segmentScopes.size() - 1));
+			this->segmentOpen = false;
+		}
+		uint32_t addScope(const char* name, bool group, uint32_t pass, uint64_t pixels)
+		{
+			auto& scopes = this->slot().scopes;
+			scopes.push_back(Scope{ name, group, pass, pixels });
+			return static_cast<uint32_t>(scopes.size() - 1);
+		}
+		void collect(FrameSlot& s)
+		{
+			if (!s.pending) return;
+			s.pending = false;
+			const auto count = static_cast<uint32_t>(s.segmentScopes.size());
+			if (count == 0) return;
+
+			std::vector<Counters> results(count);
+			const auto res = vkGetQueryPoolResults(this->deviceRef, s.pool.get(), 0, count, sizeof(Counters) * count, results.data(),
+				sizeof(Counters), VK_QUERY_RESULT_64_BIT);
+			if (res == VK_NOT_READY) { this->dropped++; return; }
+			checkError(res);
+
+			std::vector<Counters> totals(s.scopes.size(), Counters{});
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const auto scope = s.segmentScopes[i];
+				totals[scope].add(results[i]);
+				if (s.scopes[scope].group && s.scopes[scope].pass != NoScope) totals[s.scopes[scope].pass].add(results[i]);
+			}
+			const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->startTime).count();
+			for (size_t i = 0; i < s.scopes.size(); i++)
+			{
+				this->samples.push_back(Sample{ s.frame, seconds, s.scopes[i].name, s.scopes[i].group, s.scopes[i].pixels, totals[i] });
+				if (this->exportFile) this->writeRow(this->samples.back());
+				if (this->samples.size() > this->historyLimit) this->samples.pop_front();
+			}
+		}
+		void writeRow(const Sample& s)
+		{
+			const auto& c = s.counters;
+			fprintf(this->exportFile.get(), "%llu,%.4f,%s,%s,%llu,%llu,%llu,%llu,%llu,%.3f,%s\n",
+				static_cast<unsigned long long>(s.frame), s.seconds, s.name.c_str(), s.group ? "group" : "pass",
+				static_cast<unsigned long long>(c.iaVertices), static_cast<unsigned long long>(c.iaPrimitives),
+				static_cast<unsigned long long>(c.vsInvocations), static_cast<unsigned long long>(c.clippingPrimitives),
+				static_cast<unsigned long long>(c.fsInvocations), fragmentsPerPixel(s), bottleneckName(classify(s)));
+		}
+	public:
+		// enable = false(or a device without pipelineStatisticsQuery) turns every call into a no-op
+		// frameSlots: frames recorded before a slot is reused(must cover the frames in flight)
+		PipelineStatistics(Device& device, bool enable, uint32_t frameSlots = 2, uint32_t maxSegmentsPerFrame = 64, size_t historyLimit = 4096)
+			: deviceRef(device.handle()), enabled(enable && device.enabledFeatures().pipelineStatisticsQuery == VK_TRUE),
+			maxSegments(maxSegmentsPerFrame), currentSlot(0), frameNumber(0), overflows(0), dropped(0), recording(VK_NULL_HANDLE),
+			activePass(NoScope), activeGroup(NoScope), segmentOpen(false), startTime(std::chrono::steady_clock::now()),
+			historyLimit(historyLimit), exportFile(nullptr, &fclose)
+		{
+			if (!this->enabled) return;
+			for (uint32_t i = 0; i < frameSlots; i++)
+			{
+				this->slots.push_back(FrameSlot{ device.createQueryPool(VK_QUERY_TYPE_PIPELINE_STATISTICS, maxSegmentsPerFrame, CollectedStatistics),
+					std::vector<uint32_t>(), std::vector<Scope>(), 0, false });
+			}
+		}
+		PipelineStatistics(const PipelineStatistics&) = delete;
+
+		auto available() const { return this->enabled; }
+		// Appends every collected sample to a CSV file
+		void exportTo(const std::string& path)
+		{
+			this->exportFile = BinaryLoader::openForWrite(path, "w");
+			fputs("frame,seconds,scope,kind,iaVertices,iaPrimitives,vsInvocations,clippingPrimitives,fsInvocations,fragmentsPerPixel,bottleneck\n",
+				this->exportFile.get());
+		}
+
+		// Outside of render passes: reads back the results of the reused slot and resets its queries
+		void beginFrame(VkCommandBuffer buffer)
+		{
+			if (!this->enabled) return;
+			auto& s = this->slot();
+			this->collect(s);
+			s.segmentScopes.clear();
+			s.scopes.clear();
+			s.frame = this->frameNumber;
+			this->recording = buffer;
+			vkCmdResetQueryPool(buffer, s.pool.get(), 0, this->maxSegments);
+		}
+		// Call after the command buffer containing the frame was submitted(every pass and group must be ended)
+		void endFrame()
+		{
+			if (!this->enabled) return;
+			this->slot().pending = true;
+			this->currentSlot = (this->currentSlot + 1) % static_cast<uint32_t>(this->slots.size());
+			this->frameNumber++;
+			this->activePass = this->activeGroup = NoScope;
+		}
+		// Right after vkCmdBeginRenderPass / right before vkCmdEndRenderPass
+		void beginPass(const char* name, VkExtent2D renderArea)
+		{
+			if (!this->enabled) return;
+			this->closeSegment();
+			this->activePass = this->addScope(name, false, NoScope, static_cast<uint64_t>(renderArea.width) * renderArea.height);
+			this->openSegment(this->activePass);
+		}
+		void endPass()
+		{
+			if (!this->enabled) return;
+			this->closeSegment();
+			this->activePass = NoScope;
+		}
+		// Tagged draw groups(may not nest)
+		void beginGroup(const char* name)
+		{
+			if (!this->enabled) return;
+			this->closeSegment();
+			const auto pixels = this->activePass != NoScope ? this->slot().scopes[this->activePass].pixels : 0;
+			this->activeGroup = this->addScope(name, true, this->activePass, pixels);
+			this->openSegment(this->activeGroup);
+		}
+		void endGroup()
+		{
+			if (!this->enabled) return;
+			this->closeSegment();
+			this->activeGroup = NoScope;
+			if (this->activePass != NoScope) this->openSegment(this->activePass);
+		}
+
+		// Collects every submitted frame(call after the device finished them, e.g. at shutdown)
+		void flush()
+		{
+			for (auto& s : this->slots) this->collect(s);
+		}
+
+		const auto& history() const { return this->samples; }
+		auto overflowCount() const { return this->overflows; }
+		auto droppedFrames() const { return this->dropped; }
+
+		// Heuristic: more vertex shading than fragment shading -> Vertex, under 16 fragments per clipped primitive(tiny triangles) -> Raster,
+		// more than 2 fragments per pixel -> Fill
+		static double fragmentsPerPixel(const Sample& s)
+		{
+			return s.pixels == 0 ? 0.0 : static_cast<double>(s.counters.fsInvocations) / static_cast<double>(s.pixels);
+		}
+		static Bottleneck classify(const Sample& s)
+		{
+			const auto& c = s.counters;
+			if (c.vsInvocations > c.fsInvocations) return Bottleneck::Vertex;
+			if (c.clippingPrimitives > 0 && c.fsInvocations < c.clippingPrimitives * 16) return Bottleneck::Raster;
+			if (fragmentsPerPixel(s) > 2.0) return Bottleneck::Fill;
+			return Bottleneck::Balanced;
+		}
+		static const char* bottleneckName(Bottleneck b)
+		{
+			switch (b)
+			{
+			case Bottleneck::Vertex: return "vertex";
+			case Bottleneck::Raster: return "raster";
+			case Bottleneck::Fill: return "fill";
+			default: return "balanced";
+			}
+		}
+	};
+
+	// Averages the recorded history per scope
+	void dumpPipelineStatistics(const PipelineStatistics& stats)
+	{
+		OutputDebugString(L"=== Pipeline Statistics ===\n");
+		if (!stats.available()) { OutputDebugString(L"  Disabled or not supported by the device\n"); return; }
+
+		std::vector<std::pair<PipelineStatistics::Sample, uint64_t>> scopes;
+		for (const auto& s : stats.history())
+		{
+			auto found = std::find_if(scopes.begin(), scopes.end(), [&](const auto& e) { return e.first.name == s.name && e.first.group == s.group; });
+			if (found == scopes.end()) scopes.push_back(std::make_pair(s, 1));
+			else
+			{
+				found->first.counters.add(s.counters);
+				found->first.pixels += s.pixels;
+				found->second++;
+			}
+		}
+		for (const auto& e : scopes)
+		{
+			const auto& c = e.first.counters;
+			const auto n = e.second;
+			OutputDebugString(e.first.group ? L"  Group " : L"  Pass "); OutputDebugStringA(e.first.name.c_str());
+			OutputDebugString(L": vertices "); OutputDebugString(std::to_wstring(c.iaVertices / n).c_str());
+			OutputDebugString(L", primitives "); OutputDebugString(std::to_wstring(c.iaPrimitives / n).c_str());
+			OutputDebugString(L", vs "); OutputDebugString(std::to_wstring(c.vsInvocations / n).c_str());
+			OutputDebugString(L", clipped "); OutputDebugString(std::to_wstring(c.clippingPrimitives / n).c_str());
+			OutputDebugString(L", fs "); OutputDebugString(std::to_wstring(c.fsInvocations / n).c_str());
+			OutputDebugString(L" per frame("); OutputDebugString(std::to_wstring(PipelineStatistics::fragmentsPerPixel(e.first)).c_str());
+			OutputDebugString(L" fragments/pixel, "); OutputDebugStringA(PipelineStatistics::bottleneckName(PipelineStatistics::classify(e.first)));
+			OutputDebugString(L")\n");
+		}
+		OutputDebugString(L"  Overflowed segments: "); OutputDebugString(std::to_wstring(stats.overflowCount()).c_str());
+		OutputDebugString(L", dropped frames: "); OutputDebugString(std::to_wstring(stats.droppedFrames()).c_str()); OutputDebugString(L"\n");
+	}
+}
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "vkDevice.h"
+#include "vkDynamicResolution.h"
+
+namespace Vulkan
+{
+	// Post-Processing Chain
+	// Bloom(separable blur of the bright parts), tone mapping and color grading as compute passes over storage images.
+	// The chain is recorded for the compute queue(Device::computeQueue) so the post-processing of one frame overlaps
+	// the geometry of the next; the scene images must be created with Device::createSharedRenderTargetImages and be in
+	// SHADER_READ_ONLY layout when the chain runs. Intermediates are rebuilt every frame, so each in-flight frame uses its own slot.
+	// scale < 1 runs the chain at reduced resolution(the scene is downsampled by the first blur and the result upscaled by composite).
+	class PostProcessChain final
+	{
+	public:
+		static constexpr uint32_t WorkgroupSize = 8;		// local_size_x/y of the Post*.comp shaders
+		enum Effect : uint32_t { BlurHorizontal, BlurVertical, ToneMap, ColorGrade, EffectCount };
+		struct Parameters
+		{
+			float threshold;		// bloom source: scene above this luminance
+			float exposure, bloomStrength;
+			float saturation, contrast;
+		};
+		struct Timing
+		{
+			uint64_t samples;
+			double lastMilliseconds, maxMilliseconds, totalMilliseconds;
+
+			auto averageMilliseconds() const { return samples == 0 ? 0.0 : totalMilliseconds / static_cast<double>(samples); }
+		};
+	private:
+		static constexpr VkFormat IntermediateFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+		static constexpr VkFormat OutputFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+		// Push constants shared by all passes(PostBlur.comp, PostToneMap.comp, PostGrade.comp)
+		struct PushConstants
+		{
+			float direction[2];		// blur step in texture coordinates
+			float threshold, exposure, bloomStrength, saturation, contrast;
+		};
+		// ping/pong: intermediates, output: graded result read by composite on the graphics queue
+		struct Slot
+		{
+			ImageData ping, pong, output;
+			ImageView pingView, pongView, outputView;
+			VkDescriptorSet sets[EffectCount];
+			QueryPool timestamps;
+			bool pending;
+		};
+
+		VkDevice deviceRef;
+		VkExtent2D sceneExtent, extent;
+		Parameters params;
+		DescriptorSetLayout setLayout;
+		PipelineLayout layout;
+		DescriptorPool descriptorPool;
+		ShaderModule blurShader, toneMapShader, gradeShader;
+		Pipeline blurPipeline, toneMapPipeline, gradePipeline;
+		std::vector<Slot> slots;
+		bool timed;
+		double timestampPeriod;		// nanoseconds per tick
+		uint64_t timestampMask;
+		Timing timings[EffectCount];
+
+		void collect(Slot& s)
+		{
+			if (!s.pending) return;
+			s.pending = false;
+			uint64_t timestamps[EffectCount + 1];
+			const auto res = vkGetQueryPoolResults(this->deviceRef, s.timestamps.get(), 0, EffectCount + 1, sizeof(timestamps), timestamps,
+				sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+			if (res == VK_NOT_READY) return;
+			checkError(res);
+			for (uint32_t e = 0; e < EffectCount; e++)
+			{
+				const auto ticks = (timestamps[e + 1] - timestamps[e]) & this->timestampMask;
+				const auto ms = static_cast<double>(ticks) * this->timestampPeriod / 1.0e6;
+				auto& t = this->timings[e];
+				t.samples++;
+				t.lastMilliseconds = ms;
+				t.maxMilliseconds = std::max(t.maxMilliseconds, ms);
+				t.totalMilliseconds += ms;
+			}
+		}
+		void dispatch(VkCommandBuffer buffer, const Slot& s, Effect effect, const Pipeline& pipeline, const PushConstants& constants) const
+		{
+			vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.get());
+			vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->layout.get(), 0, 1, &s.sets[effect], 0, nullptr);
+			vkCmdPushConstants(buffer, this->layout.get(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &constants);
+			vkCmdDispatch(buffer, (this->extent.width + WorkgroupSize - 1) / WorkgroupSize, (this->extent.height + WorkgroupSize - 1) / WorkgroupSize, 1);
+			if (this->timed) vkCmdWriteTimestamp(buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, s.timestamps.get(), effect + 1);
+		}
+		// RAW between passes(also orders the WAR on the image the previous pass sampled)
+		static void passBarrier(VkCommandBuffer buffer, const ImageData& written)
+		{
+			barrierResource(buffer, written.first.get(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+		}
+	public:
+		// sceneViews: one slot per view; sampler: linear, clamped to edge
+		PostProcessChain(Device& device, const PipelineCache& cache, VkSampler sampler, const std::vector<VkImageView>& sceneViews,
+			VkExtent2D sceneExtent, double scale = 1.0, const std::wstring& shaderDirectory = L"")
+			: deviceRef(device.handle()), sceneExtent(sceneExtent), params{ 0.6f, 1.5f, 0.8f, 1.1f, 1.05f },
+			timed(false), timestampPeriod(1.0), timestampMask(0), timings{}
+		{
+			const auto scaled = [](uint32_t size, double scale) { return std::max(8u, static_cast<uint32_t>(size * std::min(std::max(scale, 0.1), 1.0))); };
+			this->extent = VkExtent2D{ scaled(sceneExtent.width, scale), scaled(sceneExtent.height, scale) };
+
+			// binding 0: sampled input, 1: storage input, 2: storage output
+			this->setLayout = device.createDescriptorSetLayout({
+				VkDescriptorSetLayoutBinding{ 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+				VkDescriptorSetLayoutBinding{ 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+				VkDescriptorSetLayoutBinding{ 2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr }
+			});
+			this->layout = device.createPipelineLayout({ this->setLayout.get() },
+				{ VkPushConstantRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants) } });
+			const auto setCount = static_cast<uint32_t>(sceneViews.size()) * EffectCount;
+			this->descriptorPool = device.createDescriptorPool(setCount, {
+				VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setCount },
+				VkDescriptorPoolSize{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, setCount * 2 }
+			});
+
+			this->blurShader = device.createShaderModule(shaderDirectory + L"PostBlur.comp.spv");
+			this->toneMapShader = device.createShaderModule(shaderDirectory + L"PostToneMap.comp.spv");
+			this->gradeShader = device.createShaderModule(shaderDirectory + L"PostGrade.comp.spv");
+			this->blurPipeline = device.createComputePipeline(this->blurShader, this->layout, cache);
+			this->toneMapPipeline = device.createComputePipeline(this->toneMapShader, this->layout, cache);
+			this->gradePipeline = device.createComputePipeline(this->gradeShader, this->layout, cache);
+
+			// Timestamps are written on the compute queue
+			VkPhysicalDeviceProperties props;
+			vkGetPhysicalDeviceProperties(device.physicalDevice(), &props);
+			uint32_t familyCount;
+			vkGetPhysicalDeviceQueueFamilyProperties(device.physicalDevice(), &familyCount, nullptr);
+			auto families = std::make_unique<VkQueueFamilyProperties[]>(familyCount);
+			vkGetPhysicalDeviceQueueFamilyProperties(device.physicalDevice(), &familyCount, families.get());
+			const auto validBits = families[device.computeQueueFamily()].timestampValidBits;
+			if (validBits != 0)
+			{
+				this->timed = true;
+				this->timestampPeriod = props.limits.timestampPeriod;
+				this->timestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+			}
+
+			const auto intermediateUsage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+			for (const auto sceneView : sceneViews)
+			{
+				Slot s{};
+				s.ping = device.createImage(this->extent, IntermediateFormat, intermediateUsage);
+				s.pong = device.createImage(this->extent, IntermediateFormat, intermediateUsage);
+				s.output = device.createSharedImage(this->extent, OutputFormat, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+				s.pingView = device.createImageView(s.ping.first.get(), IntermediateFormat);
+				s.pongView = device.createImageView(s.pong.first.get(), IntermediateFormat);
+				s.outputView = device.createImageView(s.output.first.get(), OutputFormat);
+				if (this->timed) s.timestamps = device.createQueryPool(VK_QUERY_TYPE_TIMESTAMP, EffectCount + 1);
+				s.pending = false;
+
+				// { sampled, storage input, storage output } per effect(unused bindings still point at valid images)
+				const VkImageView views[EffectCount][3] =
+				{
+					{ sceneView, s.pongView.get(), s.pingView.get() },				// BlurHorizontal: scene -> ping
+					{ s.pingView.get(), s.pingView.get(), s.pongView.get() },		// BlurVertical: ping -> pong
+					{ sceneView, s.pongView.get(), s.pingView.get() },				// ToneMap: scene + pong -> ping
+					{ sceneView, s.pingView.get(), s.outputView.get() }				// ColorGrade: ping -> output
+				};
+				for (uint32_t e = 0; e < EffectCount; e++)
+				{
+					s.sets[e] = device.allocateDescriptorSet(this->descriptorPool, this->setLayout);
+					const auto sampledLayout = views[e][0] == sceneView ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+					device.updateImageDescriptor(s.sets[e], 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, sampler, views[e][0], sampledLayout);
+					device.updateImageDescriptor(s.sets[e], 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_NULL_HANDLE, views[e][1], VK_IMAGE_LAYOUT_GENERAL);
+					device.updateImageDescriptor(s.sets[e], 2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_NULL_HANDLE, views[e][2], VK_IMAGE_LAYOUT_GENERAL);
+				}
+				this->slots.push_back(std::move(s));
+			}
+		}
+		PostProcessChain(const PostProcessChain&) = delete;
+
+		auto outputExtent() const { return this->extent; }
+		auto slotCount() const { return static_cast<uint32_t>(this->slots.size()); }
+		auto& parameters() { return this->params; }
+		auto timingAvailable() const { return this->timed; }
+		const auto& timing(Effect effect) const { return this->timings[effect]; }
+		static auto effectName(Effect effect)
+		{
+			static const wchar_t* names[EffectCount] = { L"Blur(H)", L"Blur(V)", L"Tone Map", L"Color Grade" };
+			return names[effect];
+		}
+
+		// Records the chain for the scene of slot into a compute queue command buffer.
+		// The previous work on the slot(including its composite) must have completed.
+		void record(VkCommandBuffer buffer, uint32_t slot)
+		{
+			auto& s = this->slots[slot];
+			this->collect(s);
+			if (this->timed)
+			{
+				vkCmdResetQueryPool(buffer, s.timestamps.get(), 0, EffectCount + 1);
+				vkCmdWriteTimestamp(buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, s.timestamps.get(), 0);
+			}
+			// Intermediates are fully overwritten; discard the previous contents
+			for (const auto image : { s.ping.first.get(), s.pong.first.get(), s.output.first.get() })
+			{
+				barrierResource(buffer, image, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					0, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+			}
+
+			const auto& p = this->params;
+			const PushConstants horizontal{ { 1.0f / this->extent.width, 0.0f }, p.threshold, p.exposure, p.bloomStrength, p.saturation, p.contrast };
+			const PushConstants vertical{ { 0.0f, 1.0f / this->extent.height }, 0.0f, p.exposure, p.bloomStrength, p.saturation, p.contrast };
+			this->dispatch(buffer, s, BlurHorizontal, this->blurPipeline, horizontal);
+			passBarrier(buffer, s.ping);
+			this->dispatch(buffer, s, BlurVertical, this->blurPipeline, vertical);
+			passBarrier(buffer, s.pong);
+			this->dispatch(buffer, s, ToneMap, this->toneMapPipeline, horizontal);
+			passBarrier(buffer, s.ping);
+			this->dispatch(buffer, s, ColorGrade, this->gradePipeline, horizontal);
+			if (this->timed) s.pending = true;
+		}
+		// Stretches the output of slot over target(graphics queue, after waiting for the chain at the TRANSFER stage).
+		// target needs transfer destination usage and is left in targetLayout.
+		void composite(VkCommandBuffer buffer, uint32_t slot, VkImage target, VkExtent2D targetExtent, VkImageLayout targetLayout) const
+		{
+			const auto output = this->slots[slot].output.first.get();
+
+			barrierResource(buffer, output, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+			barrierResource(buffer, target, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_ACCESS_MEMORY_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, targetLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+			blitUpscale(buffer, output, this->extent, target, targetExtent);
+			barrierResource(buffer, target, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_MEMORY_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, targetLayout);
+			// output stays in TRANSFER_SRC; the next record() discards it anyway
+		}
+	};
+
+	void dumpPostProcessStatistics(const PostProcessChain& chain)
+	{
+		const auto extent = chain.outputExtent();
+
+		OutputDebugString(L"=== Post-Processing Statistics ===\n");
+		OutputDebugString(L"  Resolution: "); OutputDebugString(std::to_wstring(extent.width).c_str());
+		OutputDebugString(L"x"); OutputDebugString(std::to_wstring(extent.height).c_str()); OutputDebugString(L"\n");
+		if (!chain.timingAvailable()) { OutputDebugString(L"  Timestamps are not supported on the compute queue\n"); return; }
+		double total = 0.0;
+		for (uint32_t e = 0; e < PostProcessChain::EffectCount; e++)
+		{
+			const auto effect = static_cast<PostProcessChain::Effect>(e);
+			const auto& t = chain.timing(effect);
+			total += t.averageMilliseconds();
+			OutputDebugString(L"  "); OutputDebugString(PostProcessChain::effectName(effect));
+			OutputDebugString(L": avg "); OutputDebugString(std::to_wstring(t.averageMilliseconds()).c_str());
+			OutputDebugString(L" ms, max "); OutputDebugString(std::to_wstring(t.maxMilliseconds).c_str());
+			OutputDebugString(L" ms, last "); OutputDebugString(std::to_wstring(t.lastMilliseconds).c_str());
+			OutputDebugString(L" ms ("); OutputDebugString(std::to_wstring(t.samples).c_str()); OutputDebugString(L" samples)\n");
+		}
+		OutputDebugString(L"  Total: avg "); OutputDebugString(std::to_wstring(total).c_str()); OutputDebugString(L" ms\n");
+	}
+}
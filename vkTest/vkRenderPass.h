@@ -0,0 +1,333 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+namespace Vulkan
+{
+	// Render Pass Builder
+	// Describes attachments and subpasses; load/store operations and layouts are derived from how each attachment is used,
+	// so that data which never leaves the pass is neither loaded nor written back(DONT_CARE).
+	// Transient attachments live only inside the pass and can be backed by lazily allocated(tile) memory.
+	class RenderPassBuilder final
+	{
+	public:
+		struct Attachment
+		{
+			VkFormat format;
+			VkSampleCountFlagBits samples;
+			bool external;			// bound per framebuffer(swapchain/offscreen image), contents stored
+			bool preserveContents;	// LOAD previous contents instead of clearing
+			bool clear;
+			bool resolveTarget;		// fully overwritten by a resolve: needs neither load nor clear
+			VkImageLayout initialLayout, finalLayout;
+			VkClearValue clearValue;
+			VkImageUsageFlags usage;	// accumulated from subpass references
+		};
+	private:
+		struct Subpass
+		{
+			std::vector<VkAttachmentReference> inputs, colors, resolves;
+			VkAttachmentReference depthStencil;
+		};
+		std::vector<Attachment> attachments;
+		std::vector<Subpass> subpasses;
+
+		static bool isDepthFormat(VkFormat format)
+		{
+			return format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_X8_D24_UNORM_PACK32 || format == VK_FORMAT_D32_SFLOAT
+				|| format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+		}
+		static bool hasStencil(VkFormat format)
+		{
+			return format == VK_FORMAT_S8_UINT || format == VK_FORMAT_D16_UNORM_S8_UINT
+				|| format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+		}
+		auto& currentSubpass()
+		{
+			if (this->subpasses.empty()) throw std::logic_error("subpass() must be called before adding references");
+			return this->subpasses.back();
+		}
+		bool referencedIn(const Subpass& s, uint32_t attachment) const
+		{
+			auto matches = [attachment](const VkAttachmentReference& r) { return r.attachment == attachment; };
+			return std::any_of(s.inputs.begin(), s.inputs.end(), matches) || std::any_of(s.colors.begin(), s.colors.end(), matches)
+				|| std::any_of(s.resolves.begin(), s.resolves.end(), matches) || s.depthStencil.attachment == attachment;
+		}
+		// Layout of the attachment at the end of its last use in the pass
+		VkImageLayout lastUsedLayout(uint32_t attachment) const
+		{
+			for (auto s = this->subpasses.rbegin(); s != this->subpasses.rend(); ++s)
+			{
+				if (s->depthStencil.attachment == attachment) return s->depthStencil.layout;
+				for (const auto& r : s->colors) if (r.attachment == attachment) return r.layout;
+				for (const auto& r : s->resolves) if (r.attachment == attachment) return r.layout;
+				for (const auto& r : s->inputs) if (r.attachment == attachment) return r.layout;
+			}
+			return VK_IMAGE_LAYOUT_GENERAL;
+		}
+		uint32_t add(const Attachment& a)
+		{
+			this->attachments.push_back(a);
+			return static_cast<uint32_t>(this->attachments.size() - 1);
+		}
+	public:
+		// Attachments: return index used in subpass references and framebuffers
+
+		// Image supplied by each framebuffer(e.g. swapchain image), stored at the end of the pass
+		uint32_t addExternalColor(VkFormat format, VkImageLayout finalLayout, bool clear = true, VkClearColorValue clearColor = { { 0.0f, 0.0f, 0.0f, 1.0f } })
+		{
+			VkClearValue cv;
+			cv.color = clearColor;
+			return this->add(Attachment{ format, VK_SAMPLE_COUNT_1_BIT, true, false, clear, false, VK_IMAGE_LAYOUT_UNDEFINED, finalLayout, cv, 0 });
+		}
+		// Color attachment which is consumed inside the pass(by resolve or input attachment reads) and then discarded
+		uint32_t addTransientColor(VkFormat format, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT, bool clear = true,
+			VkClearColorValue clearColor = { { 0.0f, 0.0f, 0.0f, 1.0f } })
+		{
+			VkClearValue cv;
+			cv.color = clearColor;
+			return this->add(Attachment{ format, samples, false, false, clear, false, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED, cv, 0 });
+		}
+		// Depth(/stencil) buffer which is cleared at the beginning and discarded at the end
+		uint32_t addTransientDepth(VkFormat format, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT, float clearDepth = 1.0f)
+		{
+			VkClearValue cv;
+			cv.depthStencil = { clearDepth, 0 };
+			return this->add(Attachment{ format, samples, false, false, true, false, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED, cv, 0 });
+		}
+		// Keeps contents from before the pass(loadOp = LOAD) instead of clearing
+		RenderPassBuilder& preserveContents(uint32_t attachment, VkImageLayout initialLayout)
+		{
+			this->attachments.at(attachment).preserveContents = true;
+			this->attachments.at(attachment).initialLayout = initialLayout;
+			return *this;
+		}
+
+		// Subpasses: subpass() starts a new one, following calls add references to it
+		RenderPassBuilder& subpass()
+		{
+			this->subpasses.push_back(Subpass{ {}, {}, {}, { VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED } });
+			return *this;
+		}
+		// resolveTo: single-sampled attachment receiving the resolved result at the end of this subpass
+		RenderPassBuilder& color(uint32_t attachment, uint32_t resolveTo = VK_ATTACHMENT_UNUSED)
+		{
+			auto& s = this->currentSubpass();
+			auto& a = this->attachments.at(attachment);
+			a.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+			s.colors.push_back(VkAttachmentReference{ attachment, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+			if (resolveTo != VK_ATTACHMENT_UNUSED)
+			{
+				auto& r = this->attachments.at(resolveTo);
+				if (a.samples == VK_SAMPLE_COUNT_1_BIT || r.samples != VK_SAMPLE_COUNT_1_BIT) throw std::logic_error("Resolve requires multisampled source and single-sampled destination");
+				r.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+				r.resolveTarget = true;
+			}
+			// pResolveAttachments must be parallel to pColorAttachments
+			if (resolveTo != VK_ATTACHMENT_UNUSED || !s.resolves.empty())
+			{
+				s.resolves.resize(s.colors.size() - 1, VkAttachmentReference{ VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED });
+				s.resolves.push_back(VkAttachmentReference{ resolveTo, resolveTo != VK_ATTACHMENT_UNUSED ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED });
+			}
+			return *this;
+		}
+		// Reads an attachment written by a previous subpass(subpassInput in shaders)
+		RenderPassBuilder& input(uint32_t attachment)
+		{
+			auto& a = this->attachments.at(attachment);
+			a.usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+			this->currentSubpass().inputs.push_back(VkAttachmentReference{ attachment,
+				isDepthFormat(a.format) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+			return *this;
+		}
+		RenderPassBuilder& depthStencil(uint32_t attachment, bool readOnly = false)
+		{
+			this->attachments.at(attachment).usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+			this->currentSubpass().depthStencil = VkAttachmentReference{ attachment,
+				readOnly ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+			return *this;
+		}
+
+		// Swaps a final layout of external attachments(e.g. PRESENT_SRC_KHR when replaying a swapchain pass offscreen)
+		RenderPassBuilder& replaceFinalLayout(VkImageLayout from, VkImageLayout to)
+		{
+			for (auto& a : this->attachments) if (a.external && a.finalLayout == from) a.finalLayout = to;
+			return *this;
+		}
+
+		// Flat copy of the builder state(WriterT/ReaderT: Trace::Writer/Trace::Reader)
+		template<typename WriterT> void write(WriterT& w) const
+		{
+			w.array(this->attachments);
+			w.pod(static_cast<uint32_t>(this->subpasses.size()));
+			for (const auto& s : this->subpasses)
+			{
+				w.array(s.inputs);
+				w.array(s.colors);
+				w.array(s.resolves);
+				w.pod(s.depthStencil);
+			}
+		}
+		template<typename ReaderT> static RenderPassBuilder read(ReaderT& r)
+		{
+			RenderPassBuilder builder;
+			builder.attachments = r.template array<Attachment>();
+			const auto subpassCount = r.template pod<uint32_t>();
+			for (uint32_t i = 0; i < subpassCount; i++)
+			{
+				Subpass s;
+				s.inputs = r.template array<VkAttachmentReference>();
+				s.colors = r.template array<VkAttachmentReference>();
+				s.resolves = r.template array<VkAttachmentReference>();
+				s.depthStencil = r.template pod<VkAttachmentReference>();
+				builder.subpasses.push_back(s);
+			}
+			return builder;
+		}
+
+		auto attachmentCount() const { return static_cast<uint32_t>(this->attachments.size()); }
+		auto subpassCount() const { return static_cast<uint32_t>(this->subpasses.size()); }
+		const auto& attachment(uint32_t index) const { return this->attachments.at(index); }
+		bool isTransient(uint32_t index) const { return !this->attachments.at(index).external; }
+		// Usage flags for the image backing a transient attachment
+		VkImageUsageFlags transientUsage(uint32_t index) const
+		{
+			auto usage = this->attachments.at(index).usage;
+			// Transient images may only be used as attachments(color/depth/input)
+			return usage | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		}
+		VkImageAspectFlags aspect(uint32_t index) const
+		{
+			const auto format = this->attachments.at(index).format;
+			if (!isDepthFormat(format)) return hasStencil(format) ? VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+			return hasStencil(format) ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
+		}
+		// Clear values indexed by attachment(for vkCmdBeginRenderPass)
+		auto clearValues() const
+		{
+			std::vector<VkClearValue> values(this->attachments.size());
+			for (size_t i = 0; i < this->attachments.size(); i++) values[i] = this->attachments[i].clearValue;
+			return values;
+		}
+
+		auto describeAttachments() const
+		{
+			std::vector<VkAttachmentDescription> descs(this->attachments.size());
+			for (uint32_t i = 0; i < this->attachmentCount(); i++)
+			{
+				const auto& a = this->attachments[i];
+				auto& d = descs[i];
+				d.format = a.format;
+				d.samples = a.samples;
+				// Resolve targets are overwritten entirely, so their previous contents are never needed
+				d.loadOp = a.preserveContents ? VK_ATTACHMENT_LOAD_OP_LOAD
+					: (a.clear && !a.resolveTarget) ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				d.storeOp = a.external ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				d.stencilLoadOp = hasStencil(a.format) ? d.loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				d.stencilStoreOp = hasStencil(a.format) ? d.storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+				d.initialLayout = a.preserveContents ? a.initialLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+				// Transient attachments stay in the layout of their last use(no transition at the end of the pass)
+				d.finalLayout = a.external ? a.finalLayout : this->lastUsedLayout(i);
+			}
+			return descs;
+		}
+		// Subpass descriptions point into this builder: keep it alive until vkCreateRenderPass returns
+		auto describeSubpasses(std::vector<std::vector<uint32_t>>& preserveStorage) const
+		{
+			std::vector<VkSubpassDescription> descs(this->subpasses.size());
+			preserveStorage.assign(this->subpasses.size(), std::vector<uint32_t>());
+			for (size_t i = 0; i < this->subpasses.size(); i++)
+			{
+				const auto& s = this->subpasses[i];
+				// Attachments used both before and after this subpass must be preserved through it
+				for (uint32_t a = 0; a < this->attachmentCount(); a++)
+				{
+					if (this->referencedIn(s, a)) continue;
+					const auto usedBefore = std::any_of(this->subpasses.begin(), this->subpasses.begin() + i, [&](const Subpass& p) { return this->referencedIn(p, a); });
+					const auto usedAfter = std::any_of(this->subpasses.begin() + i + 1, this->subpasses.end(), [&](const Subpass& p) { return this->referencedIn(p, a); });
+					if (usedBefore && usedAfter) preserveStorage[i].push_back(a);
+				}
+
+				auto& d = descs[i];
+				d.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+				d.inputAttachmentCount = static_cast<uint32_t>(s.inputs.size());
+				d.pInputAttachments = s.inputs.data();
+				d.colorAttachmentCount = static_cast<uint32_t>(s.colors.size());
+				d.pColorAttachments = s.colors.data();
+				d.pResolveAttachments = s.resolves.empty() ? nullptr : s.resolves.data();
+				d.pDepthStencilAttachment = s.depthStencil.attachment != VK_ATTACHMENT_UNUSED ? &s.depthStencil : nullptr;
+				d.preserveAttachmentCount = static_cast<uint32_t>(preserveStorage[i].size());
+				d.pPreserveAttachments = preserveStorage[i].data();
+			}
+			return descs;
+		}
+		// By-region dependencies let tiled GPUs keep attachment data on chip between subpasses.
+		// Each input attachment depends on the last earlier subpass writing it(intermediate subpasses may not touch it),
+		// and the first subpass drawing to an external attachment waits for color output outside the pass, so the
+		// UNDEFINED -> attachment layout transition happens after e.g. the swapchain image acquire semaphore wait.
+		auto describeDependencies() const
+		{
+			std::vector<VkSubpassDependency> deps;
+			const auto depend = [&deps](uint32_t src, uint32_t dst, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+				VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+			{
+				for (auto& d : deps)
+				{
+					if (d.srcSubpass != src || d.dstSubpass != dst) continue;
+					d.srcStageMask |= srcStage; d.srcAccessMask |= srcAccess;
+					d.dstStageMask |= dstStage; d.dstAccessMask |= dstAccess;
+					return;
+				}
+				VkSubpassDependency dep{};
+				dep.srcSubpass = src;
+				dep.dstSubpass = dst;
+				dep.srcStageMask = srcStage;
+				dep.dstStageMask = dstStage;
+				dep.srcAccessMask = srcAccess;
+				dep.dstAccessMask = dstAccess;
+				dep.dependencyFlags = src == VK_SUBPASS_EXTERNAL ? static_cast<VkDependencyFlags>(0) : VK_DEPENDENCY_BY_REGION_BIT;
+				deps.push_back(dep);
+			};
+
+			for (uint32_t i = 0; i < this->subpassCount(); i++)
+			{
+				const auto& s = this->subpasses[i];
+				const auto firstUse = std::none_of(this->subpasses.begin(), this->subpasses.begin() + i, [&](const Subpass& p)
+				{
+					for (uint32_t a = 0; a < this->attachmentCount(); a++) if (this->attachments[a].external && this->referencedIn(p, a)) return true;
+					return false;
+				});
+				for (uint32_t a = 0; a < this->attachmentCount() && firstUse; a++)
+				{
+					if (!this->attachments[a].external || !this->referencedIn(s, a)) continue;
+					depend(VK_SUBPASS_EXTERNAL, i, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+						VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | (this->attachments[a].preserveContents ? VK_ACCESS_COLOR_ATTACHMENT_READ_BIT : static_cast<VkAccessFlags>(0)));
+				}
+
+				for (const auto& input : s.inputs)
+				{
+					for (uint32_t j = i; j-- > 0;)
+					{
+						const auto& p = this->subpasses[j];
+						const auto matches = [&input](const VkAttachmentReference& r) { return r.attachment == input.attachment; };
+						if (p.depthStencil.attachment == input.attachment && p.depthStencil.layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
+						{
+							depend(j, i, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+								VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_INPUT_ATTACHMENT_READ_BIT);
+							break;
+						}
+						if (std::any_of(p.colors.begin(), p.colors.end(), matches) || std::any_of(p.resolves.begin(), p.resolves.end(), matches))
+						{
+							depend(j, i, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+								VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_INPUT_ATTACHMENT_READ_BIT);
+							break;
+						}
+					}
+				}
+			}
+			return deps;
+		}
+	};
+}
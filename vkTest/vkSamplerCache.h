@@ -0,0 +1,117 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+#include "vkUniqueObjects.h"
+
+namespace Vulkan
+{
+	// Sampler description(VkSamplerCreateInfo without sType/pNext) usable as a hash key
+	struct SamplerDesc
+	{
+		VkSamplerCreateInfo info;
+
+		SamplerDesc(const VkSamplerCreateInfo& i) : info(i)
+		{
+			this->info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+			this->info.pNext = nullptr;
+		}
+
+		size_t hash() const
+		{
+			size_t h = 0;
+			const auto combine = [&h](size_t v) { h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2); };
+			const auto& i = this->info;
+			combine(i.flags); combine(i.magFilter); combine(i.minFilter); combine(i.mipmapMode);
+			combine(i.addressModeU); combine(i.addressModeV); combine(i.addressModeW);
+			combine(std::hash<float>()(i.mipLodBias)); combine(i.anisotropyEnable); combine(std::hash<float>()(i.maxAnisotropy));
+			combine(i.compareEnable); combine(i.compareOp);
+			combine(std::hash<float>()(i.minLod)); combine(std::hash<float>()(i.maxLod));
+			combine(i.borderColor); combine(i.unnormalizedCoordinates);
+			return h;
+		}
+		bool operator==(const SamplerDesc& d) const
+		{
+			const auto& a = this->info;
+			const auto& b = d.info;
+			return a.flags == b.flags && a.magFilter == b.magFilter && a.minFilter == b.minFilter && a.mipmapMode == b.mipmapMode
+				&& a.addressModeU == b.addressModeU && a.addressModeV == b.addressModeV && a.addressModeW == b.addressModeW
+				&& a.mipLodBias == b.mipLodBias && a.anisotropyEnable == b.anisotropyEnable && a.maxAnisotropy == b.maxAnisotropy
+				&& a.compareEnable == b.compareEnable && a.compareOp == b.compareOp && a.minLod == b.minLod && a.maxLod == b.maxLod
+				&& a.borderColor == b.borderColor && a.unnormalizedCoordinates == b.unnormalizedCoordinates;
+		}
+	};
+}
+namespace std
+{
+	template<> struct hash<Vulkan::SamplerDesc>
+	{
+		size_t operator()(const Vulkan::SamplerDesc& d) const { return d.hash(); }
+	};
+}
+
+namespace Vulkan
+{
+	// Sampler Cache
+	// Identical sampler descriptions share one VkSampler(devices limit the number of live samplers).
+	// Samplers are owned by the cache and live until it is destroyed.
+	class SamplerCache final
+	{
+	public:
+		using CreatorT = std::function<Sampler(const VkSamplerCreateInfo&)>;
+		struct Statistics
+		{
+			uint64_t hits, misses;
+			size_t samplers;
+		};
+	private:
+		CreatorT creator;
+		std::mutex lock;
+		std::unordered_map<SamplerDesc, Sampler> samplers;
+		std::atomic<uint64_t> hits, misses;
+	public:
+		SamplerCache(CreatorT creator) : creator(std::move(creator)), hits(0), misses(0) {}
+		SamplerCache(const SamplerCache&) = delete;
+
+		VkSampler get(const VkSamplerCreateInfo& info)
+		{
+			const SamplerDesc desc(info);
+			std::lock_guard<std::mutex> l(this->lock);
+			auto found = this->samplers.find(desc);
+			if (found != this->samplers.end())
+			{
+				this->hits.fetch_add(1, std::memory_order_relaxed);
+				return found->second.get();
+			}
+
+			this->misses.fetch_add(1, std::memory_order_relaxed);
+			auto sampler = this->creator(desc.info);
+			const auto handle = sampler.get();
+			this->samplers.emplace(desc, std::move(sampler));
+			return handle;
+		}
+		// Common trilinear sampler
+		VkSampler getLinear(VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT, float maxLod = 16.0f)
+		{
+			VkSamplerCreateInfo info{};
+			info.magFilter = info.minFilter = VK_FILTER_LINEAR;
+			info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+			info.addressModeU = info.addressModeV = info.addressModeW = addressMode;
+			info.maxAnisotropy = 1.0f;
+			info.compareOp = VK_COMPARE_OP_NEVER;
+			info.maxLod = maxLod;
+			info.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+			return this->get(info);
+		}
+
+		auto statistics()
+		{
+			std::lock_guard<std::mutex> l(this->lock);
+			return Statistics{ this->hits.load(std::memory_order_relaxed), this->misses.load(std::memory_order_relaxed), this->samplers.size() };
+		}
+	};
+}
@@ -0,0 +1,474 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <algorithm>
+
+#include "vkDevice.h"
+#include "vkTextureReader.h"
+
+namespace Vulkan
+{
+	// Texture Streamer
+	// Textures are read through TextureReader and uploaded via a persistently mapped staging buffer in update().
+	// Mip levels stored in the file are streamed smallest first(so a blurry version is available early);
+	// textures without a mip chain get one generated on the GPU with vkCmdBlitImage.
+	// Device memory used by textures is kept under a fixed budget by evicting least recently used textures.
+	//
+	// update() records into a command buffer and reuses the staging buffer and retired objects from the previous call,
+	// so the commands recorded by the previous update() must have completed before the next one.
+	class TextureStreamer final
+	{
+	public:
+		using Handle = uint32_t;
+		static constexpr Handle InvalidHandle = UINT32_MAX;
+		enum class State { Queued, Streaming, Resident, Evicted, Failed };
+
+		struct Statistics
+		{
+			uint32_t textures, resident, streaming, failed;
+			uint32_t evictions, generatedMipChains, decodedLevels;
+			uint64_t uploadedBytes, residentBytes, budgetBytes;
+		};
+	private:
+		struct Texture
+		{
+			std::wstring path;
+			bool generateMips;
+			State state;
+			std::unique_ptr<TextureReader> reader;
+			VkFormat format;
+			bool decodeOnHost;			// BC data decoded to RGBA8 when the device cannot sample it
+			VkExtent2D extent;
+			uint32_t levelCount;		// levels of the image
+			uint32_t residentBase;		// most detailed resident level(levelCount: nothing resident)
+			bool mipsPending;			// level 0 uploaded, remaining levels generated by blits
+			Image image;
+			DeviceMemory memory;
+			ImageView view;
+			VkDeviceSize memorySize;
+			VkDeviceSize requiredSize;	// memory requirement of the image(0: not determined yet)
+			uint64_t lastUsedFrame;
+		};
+		struct Upload
+		{
+			Handle texture;
+			uint32_t level;
+			VkDeviceSize stagingOffset;
+		};
+		struct Retired
+		{
+			Image image;
+			DeviceMemory memory;
+			ImageView view;
+		};
+
+		Device& device;
+		const VkDeviceSize budget, stagingSize;
+		BufferData staging;
+		uint8_t* stagingData;
+		std::vector<Texture> textures;
+		std::vector<Retired> retired;
+		std::vector<uint8_t> decodeBuffer;
+		uint64_t frame;
+		VkDeviceSize residentBytes;
+		Statistics counters;
+
+		static auto levelBarrier(VkImage image, uint32_t baseLevel, uint32_t levelCount, VkImageLayout oldLayout, VkImageLayout newLayout,
+			VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+		{
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = srcAccess;
+			barrier.dstAccessMask = dstAccess;
+			barrier.oldLayout = oldLayout;
+			barrier.newLayout = newLayout;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, baseLevel, levelCount, 0, 1 };
+			return barrier;
+		}
+		static uint32_t fullMipCount(VkExtent2D extent)
+		{
+			uint32_t levels = 1;
+			for (auto size = std::max(extent.width, extent.height); size > 1; size >>= 1) levels++;
+			return levels;
+		}
+		static VkDeviceSize alignUp(VkDeviceSize v, VkDeviceSize alignment) { return (v + alignment - 1) & ~(alignment - 1); }
+
+		// Next level to be read from the file(UINT32_MAX if nothing left)
+		static uint32_t nextFileLevel(const Texture& t)
+		{
+			if (t.state != State::Streaming || t.mipsPending) return UINT32_MAX;
+			if (t.generateMips && t.reader->levelCount() == 1) return t.residentBase == t.levelCount ? 0 : UINT32_MAX;
+			return t.residentBase > 0 ? t.residentBase - 1 : UINT32_MAX;
+		}
+		VkDeviceSize stagingBytes(const Texture& t, uint32_t level) const
+		{
+			const auto& l = t.reader->level(level);
+			return t.decodeOnHost ? static_cast<VkDeviceSize>(l.width) * l.height * 4 : l.size;
+		}
+
+		void retire(Texture& t)
+		{
+			this->retired.push_back(Retired{ std::move(t.image), std::move(t.memory), std::move(t.view) });
+		}
+		void fail(Texture& t)
+		{
+			this->retire(t);
+			this->residentBytes -= t.memorySize;
+			t.reader.reset();
+			t.state = State::Failed;
+		}
+		// Evicts least recently used textures(not used in the current frame) until bytes fit into the budget
+		bool makeRoom(VkDeviceSize bytes, Handle requester)
+		{
+			while (this->residentBytes + bytes > this->budget)
+			{
+				auto victim = InvalidHandle;
+				for (Handle h = 0; h < this->textures.size(); h++)
+				{
+					const auto& t = this->textures[h];
+					if (h == requester || (t.state != State::Streaming && t.state != State::Resident) || t.lastUsedFrame >= this->frame) continue;
+					if (victim == InvalidHandle || t.lastUsedFrame < this->textures[victim].lastUsedFrame) victim = h;
+				}
+				if (victim == InvalidHandle) return false;
+
+				auto& t = this->textures[victim];
+				this->retire(t);
+				this->residentBytes -= t.memorySize;
+				t.reader.reset();
+				t.state = State::Evicted;
+				this->counters.evictions++;
+			}
+			return true;
+		}
+		// Image for all levels of t(not bound to memory)
+		Image createImage(const Texture& t)
+		{
+			VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+			if (t.generateMips) usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			return this->device.createImageObject(t.extent, t.format, usage, VK_SAMPLE_COUNT_1_BIT, t.levelCount);
+		}
+		// Opens the file and allocates the image(all levels) for a queued texture
+		void activate(Handle h)
+		{
+			auto& t = this->textures[h];
+			if (!t.reader)
+			{
+				try { t.reader = std::make_unique<TextureReader>(t.path); }
+				catch (const std::exception&)
+				{
+					t.state = State::Failed;
+					return;
+				}
+			}
+
+			// Format and memory requirements are determined once; a texture waiting for room only retries eviction
+			if (t.requiredSize == 0)
+			{
+				const auto sourceFormat = t.reader->pixelFormat();
+				const auto sampleable = (this->device.formatProperties(sourceFormat).optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+				t.decodeOnHost = !sampleable && TextureReader::isBlockCompressed(sourceFormat) && BlockDecoder::canDecode(sourceFormat);
+				if (!sampleable && !t.decodeOnHost)
+				{
+					t.state = State::Failed;
+					return;
+				}
+				t.format = t.decodeOnHost ? BlockDecoder::decodedFormat(sourceFormat) : sourceFormat;
+				t.extent = t.reader->extent();
+
+				// GPU mip generation needs a blittable, linearly filterable uncompressed format
+				const VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+				const auto canGenerate = t.generateMips && t.reader->levelCount() == 1 && !TextureReader::isBlockCompressed(t.format)
+					&& (this->device.formatProperties(t.format).optimalTilingFeatures & blitFeatures) == blitFeatures;
+				t.generateMips = canGenerate;
+				t.levelCount = canGenerate ? fullMipCount(t.extent) : t.reader->levelCount();
+
+				t.image = this->createImage(t);
+				VkMemoryRequirements memreq;
+				vkGetImageMemoryRequirements(this->device.handle(), t.image.get(), &memreq);
+				t.requiredSize = memreq.size;
+				if (t.requiredSize > this->budget)
+				{
+					// Could never fit, even with everything else evicted
+					t.image = Image();
+					t.reader.reset();
+					t.state = State::Failed;
+					return;
+				}
+			}
+			// Stays queued until something can be evicted(the unbound image is kept)
+			if (!this->makeRoom(t.requiredSize, h)) return;
+
+			if (t.image.get() == VK_NULL_HANDLE) t.image = this->createImage(t);
+			t.memory = this->device.allocateImageMemory(t.image.get(), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+			t.memorySize = t.requiredSize;
+			t.residentBase = t.levelCount;
+			t.mipsPending = false;
+			t.state = State::Streaming;
+			this->residentBytes += t.requiredSize;
+		}
+		// Copies one level from the file into staging memory
+		void stage(Texture& t, uint32_t level, VkDeviceSize offset)
+		{
+			const auto& l = t.reader->level(level);
+			if (t.decodeOnHost)
+			{
+				this->decodeBuffer.resize(static_cast<size_t>(l.size));
+				t.reader->readLevel(level, this->decodeBuffer.data());
+				BlockDecoder::decode(t.reader->pixelFormat(), this->decodeBuffer.data(), l.width, l.height, this->stagingData + offset);
+				this->counters.decodedLevels++;
+			}
+			else t.reader->readLevel(level, this->stagingData + offset);
+		}
+	public:
+		TextureStreamer(Device& device, VkDeviceSize memoryBudget, VkDeviceSize stagingSize = 8 * 1024 * 1024)
+			: device(device), budget(memoryBudget), stagingSize(stagingSize),
+			staging(device.createBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)),
+			stagingData(nullptr), frame(1), residentBytes(0), counters{}
+		{
+			auto res = vkMapMemory(device.handle(), this->staging.second.get(), 0, stagingSize, 0, reinterpret_cast<void**>(&this->stagingData));
+			checkError(res);
+		}
+		TextureStreamer(const TextureStreamer&) = delete;
+		~TextureStreamer()
+		{
+			if (this->stagingData != nullptr) vkUnmapMemory(this->device.handle(), this->staging.second.get());
+		}
+
+		// Registers a texture(same path returns same handle). Streaming starts at the next update().
+		Handle request(const std::wstring& path, bool generateMips = true)
+		{
+			for (Handle h = 0; h < this->textures.size(); h++)
+			{
+				if (this->textures[h].path == path) return h;
+			}
+			Texture t{};
+			t.path = path;
+			t.generateMips = generateMips;
+			t.state = State::Queued;
+			t.lastUsedFrame = this->frame;
+			this->textures.push_back(std::move(t));
+			return static_cast<Handle>(this->textures.size() - 1);
+		}
+		// Marks texture as used in this frame and returns a view of its resident levels(VK_NULL_HANDLE while nothing is resident).
+		// Evicted textures are queued again.
+		VkImageView use(Handle h)
+		{
+			auto& t = this->textures.at(h);
+			t.lastUsedFrame = this->frame;
+			if (t.state == State::Evicted) t.state = State::Queued;
+			return t.view.get();
+		}
+		auto state(Handle h) const { return this->textures.at(h).state; }
+		// Number of levels available for sampling
+		auto residentLevels(Handle h) const { return this->textures.at(h).levelCount - this->textures.at(h).residentBase; }
+
+		void beginFrame() { this->frame++; }
+
+		// Records uploads(and mip generation) for this frame. Textures end up in SHADER_READ_ONLY_OPTIMAL.
+		void update(VkCommandBuffer buffer)
+		{
+			this->retired.clear();
+			for (Handle h = 0; h < this->textures.size(); h++)
+			{
+				if (this->textures[h].state == State::Queued) this->activate(h);
+			}
+
+			// Smallest pending level first across all textures, as long as staging memory lasts
+			std::vector<Upload> uploads;
+			std::vector<bool> deferred(this->textures.size(), false);		// next level does not fit in the remaining staging memory
+			VkDeviceSize stagingOffset = 0;
+			for (;;)
+			{
+				auto next = InvalidHandle;
+				VkDeviceSize nextBytes = 0;
+				for (Handle h = 0; h < this->textures.size(); h++)
+				{
+					if (deferred[h]) continue;
+					const auto level = nextFileLevel(this->textures[h]);
+					if (level == UINT32_MAX) continue;
+					const auto bytes = this->stagingBytes(this->textures[h], level);
+					if (next == InvalidHandle || bytes < nextBytes)
+					{
+						next = h;
+						nextBytes = bytes;
+					}
+				}
+				if (next == InvalidHandle) break;
+
+				auto& t = this->textures[next];
+				const auto offset = alignUp(stagingOffset, 16);
+				if (nextBytes > this->stagingSize)
+				{
+					// Can never fit: give up on this texture
+					this->fail(t);
+					uploads.erase(std::remove_if(uploads.begin(), uploads.end(), [next](const Upload& u) { return u.texture == next; }), uploads.end());
+					continue;
+				}
+				if (offset + nextBytes > this->stagingSize)
+				{
+					// Skip this texture until the next update; other levels may still fit
+					deferred[next] = true;
+					continue;
+				}
+
+				const auto level = nextFileLevel(t);
+				try { this->stage(t, level, offset); }
+				catch (const std::exception&)
+				{
+					this->fail(t);
+					uploads.erase(std::remove_if(uploads.begin(), uploads.end(), [next](const Upload& u) { return u.texture == next; }), uploads.end());
+					continue;
+				}
+				uploads.push_back(Upload{ next, level, offset });
+				stagingOffset = offset + nextBytes;
+				this->counters.uploadedBytes += nextBytes;
+				if (t.generateMips) t.mipsPending = true;
+				else t.residentBase = level;
+			}
+			if (uploads.empty()) return;
+
+			// Batch 1: uploaded levels(whole chain for generated textures) to TRANSFER_DST
+			std::vector<VkImageMemoryBarrier> barriers;
+			for (const auto& u : uploads)
+			{
+				const auto& t = this->textures[u.texture];
+				barriers.push_back(t.generateMips
+					? levelBarrier(t.image.get(), 0, t.levelCount, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT)
+					: levelBarrier(t.image.get(), u.level, 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT));
+			}
+			vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+				0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+			for (const auto& u : uploads)
+			{
+				const auto& t = this->textures[u.texture];
+				const auto& l = t.reader->level(u.level);
+				VkBufferImageCopy region{};
+				region.bufferOffset = u.stagingOffset;
+				region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, u.level, 0, 1 };
+				region.imageExtent = { l.width, l.height, 1 };
+				vkCmdCopyBufferToImage(buffer, this->staging.first.get(), t.image.get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+			}
+
+			// Mip generation: all textures advance level by level so that each step needs a single barrier call
+			std::vector<Handle> generating;
+			uint32_t maxLevels = 0;
+			for (const auto& u : uploads)
+			{
+				const auto& t = this->textures[u.texture];
+				if (!t.generateMips) continue;
+				generating.push_back(u.texture);
+				maxLevels = std::max(maxLevels, t.levelCount);
+			}
+			for (uint32_t level = 1; level < maxLevels; level++)
+			{
+				barriers.clear();
+				for (auto h : generating)
+				{
+					const auto& t = this->textures[h];
+					if (level >= t.levelCount) continue;
+					barriers.push_back(levelBarrier(t.image.get(), level - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+						VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT));
+				}
+				vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+					0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+				for (auto h : generating)
+				{
+					const auto& t = this->textures[h];
+					if (level >= t.levelCount) continue;
+					VkImageBlit blit{};
+					blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 };
+					blit.srcOffsets[1] = { static_cast<int32_t>(std::max(t.extent.width >> (level - 1), 1u)), static_cast<int32_t>(std::max(t.extent.height >> (level - 1), 1u)), 1 };
+					blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+					blit.dstOffsets[1] = { static_cast<int32_t>(std::max(t.extent.width >> level, 1u)), static_cast<int32_t>(std::max(t.extent.height >> level, 1u)), 1 };
+					vkCmdBlitImage(buffer, t.image.get(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, t.image.get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+				}
+			}
+
+			// Final batch: everything written above to SHADER_READ_ONLY
+			barriers.clear();
+			for (const auto& u : uploads)
+			{
+				const auto& t = this->textures[u.texture];
+				if (t.generateMips)
+				{
+					if (t.levelCount > 1)
+					{
+						barriers.push_back(levelBarrier(t.image.get(), 0, t.levelCount - 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+							VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT));
+					}
+					barriers.push_back(levelBarrier(t.image.get(), t.levelCount - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+						VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+				}
+				else
+				{
+					barriers.push_back(levelBarrier(t.image.get(), u.level, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+						VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+				}
+			}
+			vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+				0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+			// Views are recreated to cover the new resident range(old ones retire until the next update)
+			for (auto h : generating)
+			{
+				auto& t = this->textures[h];
+				t.residentBase = 0;
+				t.mipsPending = false;
+				this->counters.generatedMipChains++;
+			}
+			std::vector<Handle> updated;
+			for (const auto& u : uploads)
+			{
+				if (std::find(updated.begin(), updated.end(), u.texture) == updated.end()) updated.push_back(u.texture);
+			}
+			for (auto h : updated)
+			{
+				auto& t = this->textures[h];
+				if (t.view.get() != VK_NULL_HANDLE) this->retired.push_back(Retired{ Image(), DeviceMemory(), std::move(t.view) });
+				t.view = this->device.createImageView(t.image.get(), t.format, VK_IMAGE_ASPECT_COLOR_BIT, t.residentBase, t.levelCount - t.residentBase);
+				if (t.residentBase == 0)
+				{
+					t.state = State::Resident;
+					t.reader.reset();
+				}
+			}
+		}
+
+		auto statistics() const
+		{
+			auto stats = this->counters;
+			stats.textures = static_cast<uint32_t>(this->textures.size());
+			for (const auto& t : this->textures)
+			{
+				if (t.state == State::Resident) stats.resident++;
+				else if (t.state == State::Streaming) stats.streaming++;
+				else if (t.state == State::Failed) stats.failed++;
+			}
+			stats.residentBytes = this->residentBytes;
+			stats.budgetBytes = this->budget;
+			return stats;
+		}
+	};
+
+	void dumpTextureStreamerStatistics(const TextureStreamer& streamer)
+	{
+		const auto stats = streamer.statistics();
+		OutputDebugString(L"=== Texture Streaming Statistics ===\n");
+		OutputDebugString(L"  Textures: "); OutputDebugString(std::to_wstring(stats.textures).c_str());
+		OutputDebugString(L" ("); OutputDebugString(std::to_wstring(stats.resident).c_str());
+		OutputDebugString(L" resident, "); OutputDebugString(std::to_wstring(stats.streaming).c_str());
+		OutputDebugString(L" streaming, "); OutputDebugString(std::to_wstring(stats.failed).c_str()); OutputDebugString(L" failed)\n");
+		OutputDebugString(L"  Memory: "); OutputDebugString(std::to_wstring(stats.residentBytes).c_str());
+		OutputDebugString(L" / "); OutputDebugString(std::to_wstring(stats.budgetBytes).c_str());
+		OutputDebugString(L" bytes, "); OutputDebugString(std::to_wstring(stats.evictions).c_str()); OutputDebugString(L" evictions\n");
+		OutputDebugString(L"  Uploaded: "); OutputDebugString(std::to_wstring(stats.uploadedBytes).c_str());
+		OutputDebugString(L" bytes, "); OutputDebugString(std::to_wstring(stats.generatedMipChains).c_str());
+		OutputDebugString(L" generated mip chains, "); OutputDebugString(std::to_wstring(stats.decodedLevels).c_str()); OutputDebugString(L" host decoded levels\n");
+	}
+}
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#include "binaryLoader.h"
+
+namespace Vulkan
+{
+	// Streaming DDS reader
+	// Only the header is read on open; mip levels are read one at a time on demand(in any order).
+	// Supports 2D textures in BC1-7 and 32bit RGBA/BGRA formats.
+	class TextureReader final
+	{
+	public:
+		struct Level
+		{
+			uint32_t width, height;
+			uint64_t offset, size;
+		};
+	private:
+		BinaryLoader::File file;
+		VkFormat format;
+		uint32_t width, height;
+		std::vector<Level> levels;
+
+		static constexpr uint32_t fourCC(char a, char b, char c, char d)
+		{
+			return static_cast<uint32_t>(a) | (static_cast<uint32_t>(b) << 8) | (static_cast<uint32_t>(c) << 16) | (static_cast<uint32_t>(d) << 24);
+		}
+		static VkFormat fromDXGI(uint32_t dxgiFormat)
+		{
+			switch (dxgiFormat)
+			{
+			case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+			case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+			case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+			case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+			case 74: return VK_FORMAT_BC2_UNORM_BLOCK;
+			case 75: return VK_FORMAT_BC2_SRGB_BLOCK;
+			case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+			case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+			case 80: return VK_FORMAT_BC4_UNORM_BLOCK;
+			case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+			case 95: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+			case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+			case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+			case 87: return VK_FORMAT_B8G8R8A8_UNORM;
+			case 91: return VK_FORMAT_B8G8R8A8_SRGB;
+			default: return VK_FORMAT_UNDEFINED;
+			}
+		}
+	public:
+		TextureReader(const std::wstring& path) : file(BinaryLoader::open(path)), format(VK_FORMAT_UNDEFINED)
+		{
+			// "DDS " + DDS_HEADER(124 bytes)
+			uint32_t header[32];
+			if (fread(header, sizeof(uint32_t), 32, this->file.get()) != 32 || header[0] != fourCC('D', 'D', 'S', ' ') || header[1] != 124)
+			{
+				throw std::runtime_error("Not a DDS file");
+			}
+			this->height = header[3];
+			this->width = header[4];
+			const auto mipCount = std::max(header[7], 1u);
+			const auto pfFlags = header[20], pfFourCC = header[21], pfBitCount = header[22], pfRMask = header[23];
+			const auto caps2 = header[29];
+			if (caps2 != 0) throw std::runtime_error("Cubemap and volume textures are not supported");
+
+			uint64_t dataOffset = sizeof(header);
+			if ((pfFlags & 0x04) != 0)
+			{
+				switch (pfFourCC)
+				{
+				case fourCC('D', 'X', 'T', '1'): this->format = VK_FORMAT_BC1_RGBA_UNORM_BLOCK; break;
+				case fourCC('D', 'X', 'T', '3'): this->format = VK_FORMAT_BC2_UNORM_BLOCK; break;
+				case fourCC('D', 'X', 'T', '5'): this->format = VK_FORMAT_BC3_UNORM_BLOCK; break;
+				case fourCC('A', 'T', 'I', '1'): this->format = VK_FORMAT_BC4_UNORM_BLOCK; break;
+				case fourCC('A', 'T', 'I', '2'): this->format = VK_FORMAT_BC5_UNORM_BLOCK; break;
+				case fourCC('D', 'X', '1', '0'):
+				{
+					// DDS_HEADER_DXT10
+					uint32_t dx10[5];
+					if (fread(dx10, sizeof(uint32_t), 5, this->file.get()) != 5) throw std::runtime_error("Truncated DDS file");
+					if (dx10[1] != 3 || dx10[3] > 1) throw std::runtime_error("Only single 2D textures are supported");
+					this->format = fromDXGI(dx10[0]);
+					dataOffset += sizeof(dx10);
+					break;
+				}
+				}
+			}
+			else if ((pfFlags & 0x40) != 0 && pfBitCount == 32)
+			{
+				this->format = pfRMask == 0x000000ff ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_B8G8R8A8_UNORM;
+			}
+			if (this->format == VK_FORMAT_UNDEFINED) throw std::runtime_error("Unsupported DDS pixel format");
+
+			// Levels are stored largest first
+			for (uint32_t i = 0; i < mipCount; i++)
+			{
+				const auto w = std::max(this->width >> i, 1u), h = std::max(this->height >> i, 1u);
+				const auto size = levelSize(this->format, w, h);
+				this->levels.push_back(Level{ w, h, dataOffset, size });
+				dataOffset += size;
+				if (w == 1 && h == 1) break;
+			}
+		}
+		TextureReader(const TextureReader&) = delete;
+
+		static bool isBlockCompressed(VkFormat format)
+		{
+			return format >= VK_FORMAT_BC1_RGBA_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+		}
+		static uint64_t levelSize(VkFormat format, uint32_t width, uint32_t height)
+		{
+			if (!isBlockCompressed(format)) return static_cast<uint64_t>(width) * height * 4;
+			const auto blocks = static_cast<uint64_t>((width + 3) / 4) * ((height + 3) / 4);
+			const bool eightByteBlocks = format == VK_FORMAT_BC1_RGBA_UNORM_BLOCK || format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK || format == VK_FORMAT_BC4_UNORM_BLOCK;
+			return blocks * (eightByteBlocks ? 8 : 16);
+		}
+
+		auto pixelFormat() const { return this->format; }
+		auto extent() const { return VkExtent2D{ this->width, this->height }; }
+		auto levelCount() const { return static_cast<uint32_t>(this->levels.size()); }
+		const auto& level(uint32_t index) const { return this->levels.at(index); }
+		void readLevel(uint32_t index, void* dst)
+		{
+			const auto& l = this->levels.at(index);
+			if (fseek(this->file.get(), static_cast<long>(l.offset), SEEK_SET) != 0
+				|| fread(dst, 1, static_cast<size_t>(l.size), this->file.get()) != l.size)
+			{
+				throw std::runtime_error("Truncated DDS file");
+			}
+		}
+	};
+
+	// CPU fallback for devices which cannot sample BC1-3(decodes to RGBA8)
+	namespace BlockDecoder
+	{
+		bool canDecode(VkFormat format)
+		{
+			return format == VK_FORMAT_BC1_RGBA_UNORM_BLOCK || format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+				|| format == VK_FORMAT_BC2_UNORM_BLOCK || format == VK_FORMAT_BC2_SRGB_BLOCK
+				|| format == VK_FORMAT_BC3_UNORM_BLOCK || format == VK_FORMAT_BC3_SRGB_BLOCK;
+		}
+		VkFormat decodedFormat(VkFormat format)
+		{
+			const bool srgb = format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK || format == VK_FORMAT_BC2_SRGB_BLOCK || format == VK_FORMAT_BC3_SRGB_BLOCK;
+			return srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+		}
+
+		// 4x4 color block(BC1 layout) into 16 RGBA texels
+		void decodeColorBlock(const uint8_t* block, bool allowTransparent, uint8_t(&out)[16][4])
+		{
+			const uint16_t c0 = block[0] | (block[1] << 8), c1 = block[2] | (block[3] << 8);
+			uint8_t palette[4][4];
+			const auto expand = [](uint16_t c, uint8_t(&rgba)[4])
+			{
+				rgba[0] = static_cast<uint8_t>(((c >> 11) & 0x1f) * 255 / 31);
+				rgba[1] = static_cast<uint8_t>(((c >> 5) & 0x3f) * 255 / 63);
+				rgba[2] = static_cast<uint8_t>((c & 0x1f) * 255 / 31);
+				rgba[3] = 255;
+			};
+			expand(c0, palette[0]);
+			expand(c1, palette[1]);
+			for (int ch = 0; ch < 3; ch++)
+			{
+				if (c0 > c1 || !allowTransparent)
+				{
+					palette[2][ch] = static_cast<uint8_t>((2 * palette[0][ch] + palette[1][ch]) / 3);
+					palette[3][ch] = static_cast<uint8_t>((palette[0][ch] + 2 * palette[1][ch]) / 3);
+				}
+				else
+				{
+					palette[2][ch] = static_cast<uint8_t>((palette[0][ch] + palette[1][ch]) / 2);
+					palette[3][ch] = 0;
+				}
+			}
+			palette[2][3] = 255;
+			palette[3][3] = (c0 > c1 || !allowTransparent) ? 255 : 0;
+
+			const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+			for (int i = 0; i < 16; i++) memcpy(out[i], palette[(indices >> (i * 2)) & 0x03], 4);
+		}
+		// BC3 interpolated alpha block
+		void decodeAlphaBlock(const uint8_t* block, uint8_t(&out)[16][4])
+		{
+			uint8_t alpha[8] = { block[0], block[1] };
+			if (alpha[0] > alpha[1])
+			{
+				for (int i = 1; i < 7; i++) alpha[i + 1] = static_cast<uint8_t>(((7 - i) * alpha[0] + i * alpha[1]) / 7);
+			}
+			else
+			{
+				for (int i = 1; i < 5; i++) alpha[i + 1] = static_cast<uint8_t>(((5 - i) * alpha[0] + i * alpha[1]) / 5);
+				alpha[6] = 0;
+				alpha[7] = 255;
+			}
+			uint64_t indices = 0;
+			for (int i = 0; i < 6; i++) indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+			for (int i = 0; i < 16; i++) out[i][3] = alpha[(indices >> (i * 3)) & 0x07];
+		}
+
+		// Decodes one level: dst receives width * height RGBA8 texels
+		void decode(VkFormat format, const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst)
+		{
+			const bool bc1 = format == VK_FORMAT_BC1_RGBA_UNORM_BLOCK || format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+			const bool bc2 = format == VK_FORMAT_BC2_UNORM_BLOCK || format == VK_FORMAT_BC2_SRGB_BLOCK;
+			const size_t blockBytes = bc1 ? 8 : 16;
+
+			for (uint32_t by = 0; by < (height + 3) / 4; by++)
+			{
+				for (uint32_t bx = 0; bx < (width + 3) / 4; bx++, src += blockBytes)
+				{
+					uint8_t texels[16][4];
+					decodeColorBlock(bc1 ? src : src + 8, bc1, texels);
+					if (bc2)
+					{
+						for (int i = 0; i < 16; i++) texels[i][3] = static_cast<uint8_t>(((src[i / 2] >> ((i & 1) * 4)) & 0x0f) * 17);
+					}
+					else if (!bc1) decodeAlphaBlock(src, texels);
+
+					for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++)
+					{
+						for (uint32_t x = 0; x < 4 && bx * 4 + x < width; x++)
+						{
+							memcpy(dst + ((by * 4 + y) * width + bx * 4 + x) * 4, texels[y * 4 + x], 4);
+						}
+					}
+				}
+			}
+		}
+	}
+}
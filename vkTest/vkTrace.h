@@ -0,0 +1,573 @@
+#pragma once
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+
+#include "vkDevice.h"
+#include "vkDynamicResolution.h"
+#include "binaryLoader.h"
+
+namespace Vulkan
+{
+	// Command Stream Trace
+	// Layout: header(magic, version), then records of { Op(uint8), payload size(uint32), payload }.
+	// Resources are identified by ids assigned at registration; frames are the records between BeginFrame and EndFrame.
+	namespace Trace
+	{
+		const uint32_t Magic = 0x52544b56;		// "VKTR"
+		const uint32_t Version = 1;
+
+		enum class Op : uint8_t
+		{
+			// Resources
+			RenderTarget, VertexBuffer, ShaderModule, RenderPass, Framebuffer, Pipeline,
+			// Frames
+			BeginFrame, EndFrame,
+			// Commands
+			Barrier, BeginRenderPass, EndRenderPass, BindPipeline, SetViewport, SetScissor, BindVertexBuffer, Draw, Blit
+		};
+
+		class Writer final
+		{
+			std::vector<uint8_t> data;
+		public:
+			template<typename T> void pod(const T& value)
+			{
+				const auto p = reinterpret_cast<const uint8_t*>(&value);
+				this->data.insert(this->data.end(), p, p + sizeof(T));
+			}
+			void bytes(const void* src, size_t size)
+			{
+				const auto p = reinterpret_cast<const uint8_t*>(src);
+				this->data.insert(this->data.end(), p, p + size);
+			}
+			// uint32 element count followed by the elements
+			template<typename T> void array(const T* elements, size_t count)
+			{
+				this->pod(static_cast<uint32_t>(count));
+				this->bytes(elements, sizeof(T) * count);
+			}
+			template<typename T> void array(const std::vector<T>& elements) { this->array(elements.data(), elements.size()); }
+
+			const auto& buffer() const noexcept { return this->data; }
+			void clear() noexcept { this->data.clear(); }
+		};
+		class Reader final
+		{
+			const uint8_t *ptr, *end;
+
+			const uint8_t* take(size_t size)
+			{
+				if (static_cast<size_t>(this->end - this->ptr) < size) throw std::runtime_error("Truncated trace");
+				const auto p = this->ptr;
+				this->ptr += size;
+				return p;
+			}
+		public:
+			Reader(const void* data, size_t size) : ptr(reinterpret_cast<const uint8_t*>(data)), end(ptr + size) {}
+
+			template<typename T> T pod()
+			{
+				T value;
+				memcpy(&value, this->take(sizeof(T)), sizeof(T));
+				return value;
+			}
+			const uint8_t* bytes(size_t size) { return this->take(size); }
+			template<typename T> std::vector<T> array()
+			{
+				const auto count = this->pod<uint32_t>();
+				std::vector<T> elements(count);
+				if (count > 0) memcpy(elements.data(), this->take(sizeof(T) * count), sizeof(T) * count);
+				return elements;
+			}
+
+			bool atEnd() const noexcept { return this->ptr == this->end; }
+			auto position() const noexcept { return this->ptr; }
+		};
+
+		// Non-dispatchable handles are pointers or uint64_t depending on the platform
+		template<typename HandleT> uint64_t handleKey(HandleT handle)
+		{
+			uint64_t key = 0;
+			memcpy(&key, &handle, sizeof(HandleT));
+			return key;
+		}
+	}
+
+	// Trace Recorder
+	// Forwards the command shortcuts to Vulkan and appends them to a trace file;
+	// resources referenced by commands must be registered first(registration records their creation parameters and contents).
+	// With an empty path nothing is recorded and every call only forwards.
+	class TraceRecorder final
+	{
+		BinaryLoader::File file;
+		Trace::Writer stream;
+		std::unordered_map<uint64_t, uint32_t> ids;
+		uint32_t frames;
+
+		template<typename HandleT> uint32_t assign(HandleT handle)
+		{
+			const auto id = static_cast<uint32_t>(this->ids.size());
+			this->ids[Trace::handleKey(handle)] = id;
+			return id;
+		}
+		template<typename HandleT> uint32_t id(HandleT handle) const
+		{
+			const auto it = this->ids.find(Trace::handleKey(handle));
+			if (it == this->ids.end()) throw std::logic_error("Trace: command references an unregistered resource");
+			return it->second;
+		}
+		// Appends one record; FuncT fills the payload
+		template<typename FuncT> void record(Trace::Op op, FuncT payload)
+		{
+			Trace::Writer w;
+			payload(w);
+			this->stream.pod(op);
+			this->stream.array(w.buffer());
+		}
+		void flush()
+		{
+			if (this->stream.buffer().empty()) return;
+			fwrite(this->stream.buffer().data(), 1, this->stream.buffer().size(), this->file.get());
+			fflush(this->file.get());
+			this->stream.clear();
+		}
+	public:
+		TraceRecorder(const std::string& path) : file(nullptr, &fclose), frames(0)
+		{
+			if (path.empty()) return;
+			this->file = BinaryLoader::openForWrite(path);
+			this->stream.pod(Trace::Magic);
+			this->stream.pod(Trace::Version);
+		}
+		TraceRecorder(const TraceRecorder&) = delete;
+		~TraceRecorder() { if (this->enabled()) this->flush(); }
+
+		bool enabled() const noexcept { return static_cast<bool>(this->file); }
+		auto recordedFrames() const noexcept { return this->frames; }
+
+		// Resource Registration //
+		// Color target(swapchain or offscreen image); the replay creates an offscreen image in its place
+		void renderTarget(VkImage image, VkExtent2D extent, VkFormat format, VkImageLayout initialLayout)
+		{
+			if (!this->enabled()) return;
+			const auto id = this->assign(image);
+			this->record(Trace::Op::RenderTarget, [&](Trace::Writer& w) { w.pod(id); w.pod(extent); w.pod(format); w.pod(initialLayout); });
+		}
+		void vertexBuffer(VkBuffer buffer, const void* data, size_t size)
+		{
+			if (!this->enabled()) return;
+			const auto id = this->assign(buffer);
+			this->record(Trace::Op::VertexBuffer, [&](Trace::Writer& w) { w.pod(id); w.array(reinterpret_cast<const uint8_t*>(data), size); });
+		}
+		// Stores the SPIR-V bytecode the module was created from
+		void shaderModule(VkShaderModule module, const std::wstring& path)
+		{
+			if (!this->enabled()) return;
+			const auto id = this->assign(module);
+			const auto bin = BinaryLoader::load(path);
+			this->record(Trace::Op::ShaderModule, [&](Trace::Writer& w) { w.pod(id); w.array(bin.first.get(), bin.second); });
+		}
+		void renderPass(VkRenderPass renderPass, const RenderPassBuilder& builder)
+		{
+			if (!this->enabled()) return;
+			const auto id = this->assign(renderPass);
+			this->record(Trace::Op::RenderPass, [&](Trace::Writer& w) { w.pod(id); builder.write(w); });
+		}
+		// Framebuffer over a registered render pass whose external attachment is target
+		void framebuffer(VkFramebuffer framebuffer, VkRenderPass renderPass, VkImage target, VkExtent2D extent)
+		{
+			if (!this->enabled()) return;
+			const auto rp = this->id(renderPass), image = this->id(target);
+			const auto id = this->assign(framebuffer);
+			this->record(Trace::Op::Framebuffer, [&](Trace::Writer& w) { w.pod(id); w.pod(rp); w.pod(image); w.pod(extent); });
+		}
+		// Shader modules and render pass of desc must be registered; the pipeline layout is replayed as an empty one
+		void pipeline(VkPipeline pipeline, const GraphicsPipelineDesc& desc)
+		{
+			if (!this->enabled()) return;
+			const auto vs = this->id(desc.vertexShader), fs = this->id(desc.fragmentShader), rp = this->id(desc.renderPass);
+			const auto id = this->assign(pipeline);
+			const auto writeSpec = [](Trace::Writer& w, const SpecializationData& spec)
+			{
+				const auto info = spec.info();
+				w.array(info.pMapEntries, info.mapEntryCount);
+				w.array(reinterpret_cast<const uint8_t*>(info.pData), info.dataSize);
+			};
+			this->record(Trace::Op::Pipeline, [&](Trace::Writer& w)
+			{
+				w.pod(id); w.pod(vs); w.pod(fs); w.pod(rp); w.pod(desc.subpass); w.pod(desc.state.packed());
+				writeSpec(w, desc.vertexSpec);
+				writeSpec(w, desc.fragmentSpec);
+				w.array(desc.vertexBindings);
+				w.array(desc.vertexAttributes);
+			});
+		}
+
+		// Frames //
+		void beginFrame()
+		{
+			if (!this->enabled()) return;
+			const auto index = this->frames;
+			this->record(Trace::Op::BeginFrame, [&](Trace::Writer& w) { w.pod(index); });
+		}
+		// Writes the frame out
+		void endFrame()
+		{
+			if (!this->enabled()) return;
+			this->record(Trace::Op::EndFrame, [](Trace::Writer&) {});
+			this->frames++;
+			this->flush();
+		}
+
+		// Commands(forwarded, then recorded) //
+		void barrier(VkCommandBuffer buffer, VkImage image,
+			VkPipelineStageFlags srcStageFlags, VkPipelineStageFlags dstStageFlags,
+			VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask,
+			VkImageLayout srcImageLayout, VkImageLayout dstImageLayout)
+		{
+			barrierResource(buffer, image, srcStageFlags, dstStageFlags, srcAccessMask, dstAccessMask, srcImageLayout, dstImageLayout);
+			if (!this->enabled()) return;
+			const auto id = this->id(image);
+			this->record(Trace::Op::Barrier, [&](Trace::Writer& w)
+			{
+				w.pod(id); w.pod(srcStageFlags); w.pod(dstStageFlags); w.pod(srcAccessMask); w.pod(dstAccessMask);
+				w.pod(srcImageLayout); w.pod(dstImageLayout);
+			});
+		}
+		void beginRenderPass(VkCommandBuffer buffer, const Framebuffer& frame, const RenderPass& renderPass,
+			const std::vector<VkClearValue>& clearValues, VkExtent2D extent)
+		{
+			Vulkan::beginRenderPass(buffer, frame, renderPass, clearValues, extent);
+			if (!this->enabled()) return;
+			const auto fb = this->id(frame.get()), rp = this->id(renderPass.get());
+			this->record(Trace::Op::BeginRenderPass, [&](Trace::Writer& w) { w.pod(fb); w.pod(rp); w.pod(extent); w.array(clearValues); });
+		}
+		void endRenderPass(VkCommandBuffer buffer)
+		{
+			vkCmdEndRenderPass(buffer);
+			if (!this->enabled()) return;
+			this->record(Trace::Op::EndRenderPass, [](Trace::Writer&) {});
+		}
+		void bindPipeline(VkCommandBuffer buffer, VkPipeline pipeline)
+		{
+			vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			if (!this->enabled()) return;
+			const auto id = this->id(pipeline);
+			this->record(Trace::Op::BindPipeline, [&](Trace::Writer& w) { w.pod(id); });
+		}
+		void setViewport(VkCommandBuffer buffer, const VkViewport& viewport)
+		{
+			vkCmdSetViewport(buffer, 0, 1, &viewport);
+			if (!this->enabled()) return;
+			this->record(Trace::Op::SetViewport, [&](Trace::Writer& w) { w.pod(viewport); });
+		}
+		void setScissor(VkCommandBuffer buffer, const VkRect2D& scissor)
+		{
+			vkCmdSetScissor(buffer, 0, 1, &scissor);
+			if (!this->enabled()) return;
+			this->record(Trace::Op::SetScissor, [&](Trace::Writer& w) { w.pod(scissor); });
+		}
+		void bindVertexBuffer(VkCommandBuffer buffer, VkBuffer vertexBuffer, VkDeviceSize offset = 0)
+		{
+			vkCmdBindVertexBuffers(buffer, 0, 1, &vertexBuffer, &offset);
+			if (!this->enabled()) return;
+			const auto id = this->id(vertexBuffer);
+			this->record(Trace::Op::BindVertexBuffer, [&](Trace::Writer& w) { w.pod(id); w.pod(offset); });
+		}
+		void draw(VkCommandBuffer buffer, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+		{
+			vkCmdDraw(buffer, vertexCount, instanceCount, firstVertex, firstInstance);
+			if (!this->enabled()) return;
+			this->record(Trace::Op::Draw, [&](Trace::Writer& w) { w.pod(vertexCount); w.pod(instanceCount); w.pod(firstVertex); w.pod(firstInstance); });
+		}
+		void blit(VkCommandBuffer buffer, VkImage src, VkExtent2D srcExtent, VkImage dst, VkExtent2D dstExtent, VkFilter filter)
+		{
+			blitUpscale(buffer, src, srcExtent, dst, dstExtent, filter);
+			if (!this->enabled()) return;
+			const auto s = this->id(src), d = this->id(dst);
+			this->record(Trace::Op::Blit, [&](Trace::Writer& w) { w.pod(s); w.pod(srcExtent); w.pod(d); w.pod(dstExtent); w.pod(filter); });
+		}
+	};
+
+	// Trace Player
+	// Recreates the recorded resources offscreen(presentation layouts become TRANSFER_SRC) and
+	// re-executes frames one at a time without pacing or window system.
+	class TracePlayer final
+	{
+	public:
+		struct FrameTiming
+		{
+			double recordMilliseconds;		// CPU: decoding + command buffer recording
+			double executeMilliseconds;		// submit until the fence is signaled
+		};
+	private:
+		struct Target
+		{
+			ImageDataArray image;
+			ImageViewArray view;
+			VkImageLayout initialLayout;
+		};
+		using Clock = std::chrono::steady_clock;
+
+		Device& device;
+		BinaryLoader::Data trace;
+		CommandPool cmdPool;
+		CommandBuffers cmdBuffers;
+		Fence fence;
+		PipelineLayout emptyLayout;
+		PipelineCache pipelineCache;
+		std::unordered_map<uint32_t, Target> targets;
+		std::unordered_map<uint32_t, BufferData> buffers;
+		std::unordered_map<uint32_t, ShaderModule> shaders;
+		std::unordered_map<uint32_t, RenderPass> renderPasses;
+		std::unordered_map<uint32_t, RenderPassBuilder> renderPassDescs;
+		std::unordered_map<uint32_t, FramebufferSet> framebuffers;
+		std::unordered_map<uint32_t, Pipeline> pipelines;
+		// [begin, end) of the command records of each frame
+		std::vector<std::pair<const uint8_t*, const uint8_t*>> frames;
+
+		// Presented and post-processed(sampled by compute) targets are replayed as plain transfer sources
+		static VkImageLayout offscreenLayout(VkImageLayout layout)
+		{
+			return layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR || layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+				? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : layout;
+		}
+		template<typename MapT> static auto& lookup(MapT& map, uint32_t id)
+		{
+			const auto it = map.find(id);
+			if (it == map.end()) throw std::runtime_error("Trace references an unknown resource");
+			return it->second;
+		}
+		static SpecializationData readSpecialization(Trace::Reader& r)
+		{
+			const auto entries = r.array<VkSpecializationMapEntry>();
+			const auto data = r.array<uint8_t>();
+			VkSpecializationInfo info{};
+			info.mapEntryCount = static_cast<uint32_t>(entries.size());
+			info.pMapEntries = entries.data();
+			info.dataSize = data.size();
+			info.pData = data.data();
+			return SpecializationData::from(&info);
+		}
+
+		void createResource(Trace::Op op, Trace::Reader& r)
+		{
+			const auto id = r.pod<uint32_t>();
+			switch (op)
+			{
+			case Trace::Op::RenderTarget:
+			{
+				const auto extent = r.pod<VkExtent2D>();
+				const auto format = r.pod<VkFormat>();
+				Target t{ this->device.createRenderTargetImages(1, extent, format), ImageViewArray(), offscreenLayout(r.pod<VkImageLayout>()) };
+				t.view = this->device.createImageViews(imageHandles(t.image));
+				this->targets.emplace(id, std::move(t));
+				break;
+			}
+			case Trace::Op::VertexBuffer:
+			{
+				const auto size = r.pod<uint32_t>();
+				const auto data = r.bytes(size);
+				auto buffer = this->device.createBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+				void* mapped;
+				auto res = vkMapMemory(this->device.handle(), buffer.second.get(), 0, size, 0, &mapped);
+				checkError(res);
+				memcpy(mapped, data, size);
+				vkUnmapMemory(this->device.handle(), buffer.second.get());
+				this->buffers.emplace(id, std::move(buffer));
+				break;
+			}
+			case Trace::Op::ShaderModule:
+			{
+				const auto size = r.pod<uint32_t>();
+				this->shaders.emplace(id, this->device.createShaderModule(r.bytes(size), size));
+				break;
+			}
+			case Trace::Op::RenderPass:
+			{
+				auto builder = RenderPassBuilder::read(r);
+				builder.replaceFinalLayout(VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+				builder.replaceFinalLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+				this->renderPasses.emplace(id, this->device.createRenderPass(builder));
+				this->renderPassDescs.emplace(id, std::move(builder));
+				break;
+			}
+			case Trace::Op::Framebuffer:
+			{
+				const auto rp = r.pod<uint32_t>(), image = r.pod<uint32_t>();
+				const auto extent = r.pod<VkExtent2D>();
+				this->framebuffers.emplace(id, this->device.createFramebuffers(lookup(this->renderPasses, rp), lookup(this->renderPassDescs, rp),
+					lookup(this->targets, image).view, extent));
+				break;
+			}
+			case Trace::Op::Pipeline:
+			{
+				GraphicsPipelineDesc desc;
+				desc.vertexShader = lookup(this->shaders, r.pod<uint32_t>()).get();
+				desc.fragmentShader = lookup(this->shaders, r.pod<uint32_t>()).get();
+				desc.renderPass = lookup(this->renderPasses, r.pod<uint32_t>()).get();
+				desc.subpass = r.pod<uint32_t>();
+				desc.state = PipelineStateKey(r.pod<uint32_t>());
+				desc.vertexSpec = readSpecialization(r);
+				desc.fragmentSpec = readSpecialization(r);
+				desc.vertexBindings = r.array<VkVertexInputBindingDescription>();
+				desc.vertexAttributes = r.array<VkVertexInputAttributeDescription>();
+				desc.layout = this->emptyLayout.get();
+				this->pipelines.emplace(id, this->device.createGraphicsPipeline(desc, this->pipelineCache));
+				break;
+			}
+			default: throw std::runtime_error("Unexpected record in trace");
+			}
+		}
+		void executeCommand(VkCommandBuffer buffer, Trace::Op op, Trace::Reader& r)
+		{
+			switch (op)
+			{
+			case Trace::Op::Barrier:
+			{
+				const auto image = lookup(this->targets, r.pod<uint32_t>()).image.first[0].first.get();
+				const auto srcStage = r.pod<VkPipelineStageFlags>(), dstStage = r.pod<VkPipelineStageFlags>();
+				const auto srcAccess = r.pod<VkAccessFlags>(), dstAccess = r.pod<VkAccessFlags>();
+				const auto srcLayout = r.pod<VkImageLayout>(), dstLayout = r.pod<VkImageLayout>();
+				barrierResource(buffer, image, srcStage, dstStage, srcAccess, dstAccess, offscreenLayout(srcLayout), offscreenLayout(dstLayout));
+				break;
+			}
+			case Trace::Op::BeginRenderPass:
+			{
+				const auto& fb = lookup(this->framebuffers, r.pod<uint32_t>()).framebuffers.first[0];
+				const auto& rp = lookup(this->renderPasses, r.pod<uint32_t>());
+				const auto extent = r.pod<VkExtent2D>();
+				Vulkan::beginRenderPass(buffer, fb, rp, r.array<VkClearValue>(), extent);
+				break;
+			}
+			case Trace::Op::EndRenderPass: vkCmdEndRenderPass(buffer); break;
+			case Trace::Op::BindPipeline:
+				vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, lookup(this->pipelines, r.pod<uint32_t>()).get());
+				break;
+			case Trace::Op::SetViewport:
+			{
+				const auto vp = r.pod<VkViewport>();
+				vkCmdSetViewport(buffer, 0, 1, &vp);
+				break;
+			}
+			case Trace::Op::SetScissor:
+			{
+				const auto sc = r.pod<VkRect2D>();
+				vkCmdSetScissor(buffer, 0, 1, &sc);
+				break;
+			}
+			case Trace::Op::BindVertexBuffer:
+			{
+				const auto vb = lookup(this->buffers, r.pod<uint32_t>()).first.get();
+				const auto offset = r.pod<VkDeviceSize>();
+				vkCmdBindVertexBuffers(buffer, 0, 1, &vb, &offset);
+				break;
+			}
+			case Trace::Op::Draw:
+			{
+				const auto vertexCount = r.pod<uint32_t>(), instanceCount = r.pod<uint32_t>();
+				const auto firstVertex = r.pod<uint32_t>(), firstInstance = r.pod<uint32_t>();
+				vkCmdDraw(buffer, vertexCount, instanceCount, firstVertex, firstInstance);
+				break;
+			}
+			case Trace::Op::Blit:
+			{
+				const auto src = lookup(this->targets, r.pod<uint32_t>()).image.first[0].first.get();
+				const auto srcExtent = r.pod<VkExtent2D>();
+				const auto dst = lookup(this->targets, r.pod<uint32_t>()).image.first[0].first.get();
+				const auto dstExtent = r.pod<VkExtent2D>();
+				blitUpscale(buffer, src, srcExtent, dst, dstExtent, r.pod<VkFilter>());
+				break;
+			}
+			default: throw std::runtime_error("Unexpected record in frame");
+			}
+		}
+	public:
+		// Loads the whole trace, creates every resource and moves render targets to their recorded initial layouts
+		TracePlayer(Device& device, const std::wstring& path) : device(device), trace(BinaryLoader::load(path)),
+			cmdPool(device.createCommandPool()), cmdBuffers(device.createCommandBuffers(cmdPool, 1)), fence(device.createFence()),
+			emptyLayout(device.createPipelineLayout()), pipelineCache(device.createPipelineCache())
+		{
+			Trace::Reader file(this->trace.first.get(), this->trace.second);
+			if (file.pod<uint32_t>() != Trace::Magic) throw std::runtime_error("Not a trace file");
+			if (file.pod<uint32_t>() != Trace::Version) throw std::runtime_error("Unsupported trace version");
+
+			const uint8_t* frameBegin = nullptr;
+			while (!file.atEnd())
+			{
+				const auto recordBegin = file.position();
+				const auto op = file.pod<Trace::Op>();
+				const auto size = file.pod<uint32_t>();
+				Trace::Reader payload(file.bytes(size), size);
+				if (op == Trace::Op::BeginFrame) frameBegin = file.position();
+				else if (op == Trace::Op::EndFrame)
+				{
+					if (frameBegin == nullptr) throw std::runtime_error("EndFrame without BeginFrame");
+					this->frames.emplace_back(frameBegin, recordBegin);
+					frameBegin = nullptr;
+				}
+				else if (op < Trace::Op::BeginFrame) this->createResource(op, payload);
+			}
+
+			beginCommandWithFramebuffer(this->cmdBuffers[0], Framebuffer());
+			for (const auto& t : this->targets) initialImageLayouting(this->cmdBuffers[0], imageHandles(t.second.image), t.second.initialLayout);
+			auto res = vkEndCommandBuffer(this->cmdBuffers[0]);
+			checkError(res);
+			device.submitCommandAndWait(this->cmdBuffers[0]);
+		}
+		TracePlayer(const TracePlayer&) = delete;
+
+		auto frameCount() const { return static_cast<uint32_t>(this->frames.size()); }
+
+		// Records and executes one frame, waiting for its completion
+		FrameTiming replayFrame(uint32_t index)
+		{
+			const auto& range = this->frames.at(index);
+			const auto buffer = this->cmdBuffers[0];
+			const auto recordStart = Clock::now();
+
+			beginCommandWithFramebuffer(buffer, Framebuffer());
+			Trace::Reader r(range.first, range.second - range.first);
+			while (!r.atEnd())
+			{
+				const auto op = r.pod<Trace::Op>();
+				const auto size = r.pod<uint32_t>();
+				Trace::Reader payload(r.bytes(size), size);
+				this->executeCommand(buffer, op, payload);
+			}
+			auto res = vkEndCommandBuffer(buffer);
+			checkError(res);
+
+			const auto submitTime = Clock::now();
+			this->device.submitCommands(buffer, this->fence);
+			res = this->device.waitForFence(this->fence);
+			checkError(res);
+			const auto completeTime = Clock::now();
+			this->device.resetFence(this->fence);
+
+			return FrameTiming
+			{
+				std::chrono::duration<double, std::milli>(submitTime - recordStart).count(),
+				std::chrono::duration<double, std::milli>(completeTime - submitTime).count()
+			};
+		}
+		// All frames in order, loops times
+		auto replay(uint32_t loops = 1)
+		{
+			std::vector<FrameTiming> timings;
+			timings.reserve(static_cast<size_t>(this->frameCount()) * loops);
+			for (uint32_t l = 0; l < loops; l++)
+			{
+				for (uint32_t i = 0; i < this->frameCount(); i++) timings.push_back(this->replayFrame(i));
+			}
+			return timings;
+		}
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 
-#define UnwrappableObjectTraitImpl(ObjectT) private: ObjectT obj; public: auto& get() const noexcept { return this->obj; }
+#define UnwrappableObjectTraitImpl(ObjectT) private: ObjectT obj; public: auto& get() const noexcept { return this->obj; }\
+	auto allocationCallbacks() const noexcept { return this->allocator; }
 
 namespace Vulkan
 {
@@ -9,19 +10,21 @@ namespace Vulkan
 	{
 		using DestroyerT = std::function<void(ObjectT, const VkAllocationCallbacks*)>;
 		DestroyerT destroyer;
+		const VkAllocationCallbacks* allocator;
 
 		UnwrappableObjectTraitImpl(ObjectT);
 
-		UniqueObject() : obj(nullptr) {}
-		UniqueObject(ObjectT o, DestroyerT d) : obj(o), destroyer(d) {}
+		UniqueObject() : obj(nullptr), allocator(nullptr) {}
+		UniqueObject(ObjectT o, DestroyerT d, const VkAllocationCallbacks* a = nullptr) : obj(o), destroyer(d), allocator(a) {}
 		UniqueObject(const UniqueObject&) = delete;
-		~UniqueObject() { if (obj != nullptr) destroyer(obj, nullptr); }
+		~UniqueObject() { if (obj != nullptr) destroyer(obj, allocator); }
 
-		UniqueObject(UniqueObject&& b) : obj(b.obj), destroyer(b.destroyer) { b.obj = nullptr; }
+		UniqueObject(UniqueObject&& b) : obj(b.obj), destroyer(b.destroyer), allocator(b.allocator) { b.obj = nullptr; }
 		auto& operator=(UniqueObject&& b)
 		{
 			obj = b.obj;
 			destroyer = b.destroyer;
+			allocator = b.allocator;
 			b.obj = nullptr;
 			return *this;
 		}
@@ -31,23 +34,25 @@ namespace Vulkan
 		using DestroyerT = std::function<void(VkInstance, ObjectT, const VkAllocationCallbacks*)>;
 		DestroyerT destroyer;
 		VkInstance instanceRef;
+		const VkAllocationCallbacks* allocator;
 
 		UnwrappableObjectTraitImpl(ObjectT);
 
-		UniqueObjectWithInstance() : obj(nullptr) {}
-		UniqueObjectWithInstance(VkInstance instance, ObjectT o, DestroyerT d) : obj(o), destroyer(d), instanceRef(instance) {}
+		UniqueObjectWithInstance() : obj(nullptr), allocator(nullptr) {}
+		UniqueObjectWithInstance(VkInstance instance, ObjectT o, DestroyerT d, const VkAllocationCallbacks* a = nullptr) : obj(o), destroyer(d), instanceRef(instance), allocator(a) {}
 		UniqueObjectWithInstance(const UniqueObjectWithInstance&) = delete;
-		UniqueObjectWithInstance(UniqueObjectWithInstance&& o) : obj(o.obj), destroyer(o.destroyer), instanceRef(o.instanceRef)
+		UniqueObjectWithInstance(UniqueObjectWithInstance&& o) : obj(o.obj), destroyer(o.destroyer), instanceRef(o.instanceRef), allocator(o.allocator)
 		{
 			o.obj = nullptr;
 		}
-		~UniqueObjectWithInstance() { if (obj != nullptr) destroyer(instanceRef, obj, nullptr); }
+		~UniqueObjectWithInstance() { if (obj != nullptr) destroyer(instanceRef, obj, allocator); }
 
 		auto& operator=(UniqueObjectWithInstance&& b)
 		{
 			obj = b.obj;
 			destroyer = b.destroyer;
 			instanceRef = b.instanceRef;
+			allocator = b.allocator;
 			b.obj = nullptr;
 			return *this;
 		}
@@ -58,23 +63,25 @@ namespace Vulkan
 		using DestroyerT = std::function<void(VkInstance, uint64_t, const VkAllocationCallbacks*)>;
 		DestroyerT destroyer;
 		VkInstance instanceRef;
+		const VkAllocationCallbacks* allocator;
 
 		UnwrappableObjectTraitImpl(uint64_t);
 
-		UniqueObjectWithInstance() : obj(0) {}
-		UniqueObjectWithInstance(VkInstance instance, uint64_t o, DestroyerT d) : obj(o), destroyer(d), instanceRef(instance) {}
+		UniqueObjectWithInstance() : obj(0), allocator(nullptr) {}
+		UniqueObjectWithInstance(VkInstance instance, uint64_t o, DestroyerT d, const VkAllocationCallbacks* a = nullptr) : obj(o), destroyer(d), instanceRef(instance), allocator(a) {}
 		UniqueObjectWithInstance(const UniqueObjectWithInstance&) = delete;
-		UniqueObjectWithInstance(UniqueObjectWithInstance&& o) : obj(o.obj), destroyer(o.destroyer), instanceRef(o.instanceRef)
+		UniqueObjectWithInstance(UniqueObjectWithInstance&& o) : obj(o.obj), destroyer(o.destroyer), instanceRef(o.instanceRef), allocator(o.allocator)
 		{
 			o.obj = 0;
 		}
-		~UniqueObjectWithInstance() { if (obj != 0) destroyer(instanceRef, obj, nullptr); }
+		~UniqueObjectWithInstance() { if (obj != 0) destroyer(instanceRef, obj, allocator); }
 
 		auto& operator=(UniqueObjectWithInstance&& b)
 		{
 			obj = b.obj;
 			destroyer = b.destroyer;
 			instanceRef = b.instanceRef;
+			allocator = b.allocator;
 			b.obj = 0;
 			return *this;
 		}
@@ -84,23 +91,25 @@ namespace Vulkan
 		using DestroyerT = std::function<void(VkDevice, ObjectT, const VkAllocationCallbacks*)>;
 		VkDevice deviceRef;
 		DestroyerT destroyer;
+		const VkAllocationCallbacks* allocator;
 
 		UnwrappableObjectTraitImpl(ObjectT);
 
-		UniqueObjectWithDevice() : obj(nullptr) {}
-		UniqueObjectWithDevice(VkDevice device, ObjectT o, DestroyerT d) : obj(o), destroyer(d), deviceRef(device) {}
+		UniqueObjectWithDevice() : obj(nullptr), allocator(nullptr) {}
+		UniqueObjectWithDevice(VkDevice device, ObjectT o, DestroyerT d, const VkAllocationCallbacks* a = nullptr) : obj(o), destroyer(d), deviceRef(device), allocator(a) {}
 		UniqueObjectWithDevice(const UniqueObjectWithDevice&) = delete;
-		UniqueObjectWithDevice(UniqueObjectWithDevice&& o) : obj(o.obj), destroyer(o.destroyer), deviceRef(o.deviceRef)
+		UniqueObjectWithDevice(UniqueObjectWithDevice&& o) : obj(o.obj), destroyer(o.destroyer), deviceRef(o.deviceRef), allocator(o.allocator)
 		{
 			o.obj = nullptr;
 		}
-		~UniqueObjectWithDevice() { if (obj != nullptr) destroyer(deviceRef, obj, nullptr); }
+		~UniqueObjectWithDevice() { if (obj != nullptr) destroyer(deviceRef, obj, allocator); }
 
 		auto& operator=(UniqueObjectWithDevice&& b)
 		{
 			obj = b.obj;
 			destroyer = b.destroyer;
 			deviceRef = b.deviceRef;
+			allocator = b.allocator;
 			b.obj = nullptr;
 			return *this;
 		}
@@ -111,23 +120,25 @@ namespace Vulkan
 		using DestroyerT = std::function<void(VkDevice, uint64_t, const VkAllocationCallbacks*)>;
 		VkDevice deviceRef;
 		DestroyerT destroyer;
+		const VkAllocationCallbacks* allocator;
 
 		UnwrappableObjectTraitImpl(uint64_t);
 
-		UniqueObjectWithDevice() : obj(0) {}
-		UniqueObjectWithDevice(VkDevice device, uint64_t o, DestroyerT d) : obj(o), destroyer(d), deviceRef(device) {}
+		UniqueObjectWithDevice() : obj(0), allocator(nullptr) {}
+		UniqueObjectWithDevice(VkDevice device, uint64_t o, DestroyerT d, const VkAllocationCallbacks* a = nullptr) : obj(o), destroyer(d), deviceRef(device), allocator(a) {}
 		UniqueObjectWithDevice(const UniqueObjectWithDevice&) = delete;
-		UniqueObjectWithDevice(UniqueObjectWithDevice&& o) : obj(o.obj), destroyer(o.destroyer), deviceRef(o.deviceRef)
+		UniqueObjectWithDevice(UniqueObjectWithDevice&& o) : obj(o.obj), destroyer(o.destroyer), deviceRef(o.deviceRef), allocator(o.allocator)
 		{
 			o.obj = 0;
 		}
-		~UniqueObjectWithDevice() { if (obj != 0) destroyer(deviceRef, obj, nullptr); }
+		~UniqueObjectWithDevice() { if (obj != 0) destroyer(deviceRef, obj, allocator); }
 
 		auto& operator=(UniqueObjectWithDevice&& b)
 		{
 			obj = b.obj;
 			destroyer = b.destroyer;
 			deviceRef = b.deviceRef;
+			allocator = b.allocator;
 			b.obj = 0;
 			return *this;
 		}
@@ -170,6 +181,7 @@ namespace Vulkan
 	using Surface = UniqueObjectWithInstance<VkSurfaceKHR>;
 	using CommandPool = UniqueObjectWithDevice<VkCommandPool>;
 	using Swapchain = UniqueObjectWithDevice<VkSwapchainKHR>;
+	using Image = UniqueObjectWithDevice<VkImage>;
 	using ImageView = UniqueObjectWithDevice<VkImageView>;
 	using RenderPass = UniqueObjectWithDevice<VkRenderPass>;
 	using Framebuffer = UniqueObjectWithDevice<VkFramebuffer>;
@@ -177,12 +189,20 @@ namespace Vulkan
 	using DeviceMemory = UniqueObjectWithDevice<VkDeviceMemory>;
 	using ShaderModule = UniqueObjectWithDevice<VkShaderModule>;
 	using PipelineLayout = UniqueObjectWithDevice<VkPipelineLayout>;
+	using DescriptorSetLayout = UniqueObjectWithDevice<VkDescriptorSetLayout>;
+	using DescriptorPool = UniqueObjectWithDevice<VkDescriptorPool>;
 	using PipelineCache = UniqueObjectWithDevice<VkPipelineCache>;
 	using Pipeline = UniqueObjectWithDevice<VkPipeline>;
 	using Fence = UniqueObjectWithDevice<VkFence>;
+	using Semaphore = UniqueObjectWithDevice<VkSemaphore>;
+	using CommandBuffer = UniqueObjectWithDevice<VkCommandBuffer>;
+	using Sampler = UniqueObjectWithDevice<VkSampler>;
+	using QueryPool = UniqueObjectWithDevice<VkQueryPool>;
 
 	// Fixed and Unique Array
 	template<typename Element> using UniqueArray = std::pair<std::unique_ptr<Element[]>, uint32_t>;
 
 	template<typename ElementT> constexpr auto size(const UniqueArray<ElementT>& a) { return a.second; }
+	// Element count of a fixed array as a Vulkan count(std::size needs C++17)
+	template<typename ElementT, size_t N> constexpr uint32_t size(const ElementT(&)[N]) { return static_cast<uint32_t>(N); }
 }